@@ -0,0 +1,19 @@
+#!/bin/bash
+# Times comparisons of two equal q-expression literals, with and without interning.
+# Run from the root of the repository, after `make`.
+
+script=$(mktemp --suffix .dlsp)
+literal="{$(seq -s ' ' 1000)}"
+
+cat > "$script" <<DLSP
+(shelf {a} $literal)
+(shelf {b} $literal)
+(say (loop {i n} 0 0 {if (smaller i 100000) {recur (add i 1) (add n (same a b))} {n}}))
+DLSP
+
+for flag in --no-intern ""; do
+    echo "${flag:-interned}:"
+    time ./d-lisp $flag "$script"
+done
+
+rm "$script"
@@ -0,0 +1,125 @@
+// Throughput of the packed array kernels, for each instruction set the CPU supports.
+// Build with `make bench`, run with `./bench/simd [elements] [repetitions]`.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "simd.h"
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Keep results alive so the kernels are not optimized out.
+static volatile double sink;
+
+static void report(const char *kernel, const lsimd_t *kernels, size_t bytes, int reps, double start)
+{
+    double elapsed = now() - start;
+
+    printf("%-8s %-12s %8.2f GB/s\n", kernels->name, kernel, (double)bytes * reps / elapsed / 1e9);
+}
+
+static void bench(const lsimd_t *kernels, size_t n, int reps)
+{
+    int64_t *ia = malloc(sizeof(int64_t) * n);
+    int64_t *ib = malloc(sizeof(int64_t) * n);
+    int64_t *ir = malloc(sizeof(int64_t) * n);
+    double *fa = malloc(sizeof(double) * n);
+    double *fb = malloc(sizeof(double) * n);
+    double *fr = malloc(sizeof(double) * n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        ia[i] = (int64_t)(i % 1000);
+        ib[i] = (int64_t)(i % 7);
+        fa[i] = (double)(i % 1000) * 0.5;
+        fb[i] = (double)(i % 7) * 0.25;
+    }
+
+    size_t in = sizeof(double) * n;
+    double start;
+    int64_t out;
+
+    start = now();
+    for (int r = 0; r < reps; ++r)
+        sink = kernels->sum_int(ia, n, &out) ? out : 0;
+    report("sum int", kernels, in, reps, start);
+
+    start = now();
+    for (int r = 0; r < reps; ++r)
+        sink = kernels->sum_float(fa, n);
+    report("sum float", kernels, in, reps, start);
+
+    start = now();
+    for (int r = 0; r < reps; ++r)
+        sink = kernels->max_int(ia, n);
+    report("max int", kernels, in, reps, start);
+
+    start = now();
+    for (int r = 0; r < reps; ++r)
+        sink = kernels->min_float(fa, n);
+    report("min float", kernels, in, reps, start);
+
+    start = now();
+    for (int r = 0; r < reps; ++r)
+        sink = kernels->dot_float(fa, fb, n);
+    report("dot float", kernels, 2 * in, reps, start);
+
+    start = now();
+    for (int r = 0; r < reps; ++r)
+        sink = kernels->add_int(ir, ia, ib, n);
+    report("add int", kernels, 3 * in, reps, start);
+
+    start = now();
+    for (int r = 0; r < reps; ++r)
+        kernels->mul_float(fr, fa, fb, n);
+    report("mul float", kernels, 3 * in, reps, start);
+
+    start = now();
+    for (int r = 0; r < reps; ++r)
+        kernels->cmp_int(ir, ia, ib, n, LSIMD_GT);
+    report("cmp int", kernels, 3 * in, reps, start);
+
+    start = now();
+    for (int r = 0; r < reps; ++r)
+        kernels->cmp_float(ir, fa, fb, n, LSIMD_LT);
+    report("cmp float", kernels, 3 * in, reps, start);
+
+    sink = ir[n / 2] + fr[n / 2];
+
+    free(ia);
+    free(ib);
+    free(ir);
+    free(fa);
+    free(fb);
+    free(fr);
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1 << 16;
+    int reps = argc > 2 ? atoi(argv[2]) : 2000;
+
+    const lsimd_t *all[] = {
+        &lsimd_scalar,
+#if defined(__x86_64__)
+        &lsimd_sse2,
+        &lsimd_avx2,
+#endif
+    };
+
+    printf("%zu elements, %d repetitions, best kernels: %s\n", n, reps, lsimd_best()->name);
+
+    for (size_t i = 0; i < sizeof(all) / sizeof(*all); ++i)
+    {
+        if (lsimd_supported(all[i]))
+            bench(all[i], n, reps);
+    }
+
+    return 0;
+}
@@ -0,0 +1,8 @@
+#!/bin/bash
+# Times a map/filter/fold pipeline against the same pipeline run through `transduce`.
+# Run from the root of the repository, after `make`.
+
+for script in unfused fused; do
+    echo "$script:"
+    time ./d-lisp "bench/$script.dlsp"
+done
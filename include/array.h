@@ -0,0 +1,35 @@
+#ifndef ARRAY_H_
+#define ARRAY_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Alignment of the elements of a packed array, enough for any vector load.
+#define LARRAY_ALIGNMENT 32
+
+typedef enum
+{
+  ARRAY_INT,
+  ARRAY_FLOAT,
+} larray_kind_t;
+
+// Homogeneous numbers stored contiguously, instead of one lval per element.
+typedef struct
+{
+  larray_kind_t kind;
+  size_t count;
+
+  union {
+    int64_t *ints;
+    double *floats;
+  };
+} larray_t;
+
+larray_t *larray_new(larray_kind_t, size_t);
+larray_t *larray_clone(const larray_t *);
+void larray_del(larray_t *);
+
+bool larray_eq(const larray_t *, const larray_t *);
+
+#endif // ARRAY_H_
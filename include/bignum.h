@@ -0,0 +1,41 @@
+#ifndef BIGNUM_H_
+#define BIGNUM_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Operands with fewer limbs are multiplied with the schoolbook algorithm,
+// larger ones are split in halves with Karatsuba's.
+#define LBIG_KARATSUBA_THRESHOLD 32
+
+// Arbitrary-precision integer, used once a number does not fit a `long`.
+typedef struct
+{
+  bool negative;
+
+  // Magnitude in base 2^32, least significant limb first,
+  // without leading zero limbs. Zero has no limbs.
+  size_t count;
+  uint32_t limbs[];
+} lbig_t;
+
+lbig_t *lbig_from_long(long);
+lbig_t *lbig_read(const char *);
+lbig_t *lbig_clone(const lbig_t *);
+void lbig_del(lbig_t *);
+
+bool lbig_to_long(const lbig_t *, long *);
+double lbig_to_double(const lbig_t *);
+bool lbig_is_zero(const lbig_t *);
+int lbig_cmp(const lbig_t *, const lbig_t *);
+
+lbig_t *lbig_neg(const lbig_t *);
+lbig_t *lbig_add(const lbig_t *, const lbig_t *);
+lbig_t *lbig_sub(const lbig_t *, const lbig_t *);
+lbig_t *lbig_mul(const lbig_t *, const lbig_t *);
+lbig_t *lbig_divmod(const lbig_t *, const lbig_t *, lbig_t **);
+
+char *lbig_to_string(const lbig_t *);
+
+#endif // BIGNUM_H_
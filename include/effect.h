@@ -0,0 +1,29 @@
+#ifndef EFFECT_H_
+#define EFFECT_H_
+
+#include "lval.h"
+
+// What running a recipe can do besides computing its result,
+// ordered from the most to the least restrictive.
+typedef enum
+{
+  // The result only depends on the arguments.
+  PURE,
+  // The result can depend on values defined in the global environment.
+  READS_GLOBALS,
+  // The result can depend on hash tables or string builders, which change in place. It is never cached.
+  READS_STATE,
+  // The recipe prints, defines, loads or calls unknown code.
+  EFFECTFUL,
+} leffect_t;
+
+void ldeps_add(ldeps_t *, const char *);
+void ldeps_merge(ldeps_t *, const ldeps_t *);
+void ldeps_clear(ldeps_t *);
+bool ldeps_stale(ldeps_t *, lenv_t *);
+bool ldeps_shadowed(const ldeps_t *, lenv_t *);
+
+leffect_t lval_effect(lenv_t *, lval_t *, ldeps_t *);
+char *leffect_name(leffect_t);
+
+#endif // EFFECT_H_
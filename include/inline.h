@@ -0,0 +1,12 @@
+#ifndef INLINE_H_
+#define INLINE_H_
+
+#include "lval.h"
+
+// Maximum number of nodes in the body of a recipe for it to be inlined.
+#define INLINE_MAX_SIZE 16
+
+lval_t *lval_inline(lenv_t *, const llambda_t *, ldeps_t *);
+lval_t *llambda_code(llambda_t *, lenv_t *);
+
+#endif // INLINE_H_
@@ -5,10 +5,32 @@
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <limits.h>
+#include <math.h>
 #include "parser.h"
+#include "bignum.h"
+#include "array.h"
+#include "text.h"
 
 #define COMPOUND_CHAR_COUNT 4
 
+// Minimum number of floats for `add` and `mix` to take their vectorized path.
+#define LVAL_VECTOR_MIN 8
+
+// Symbols shorter than this, and expressions of at most `LVAL_INLINE_CELLS`
+// children, are stored inside their lval instead of a separate allocation.
+#define LVAL_INLINE_SYMBOL 32
+#define LVAL_INLINE_CELLS 4
+
+// Maximum number of typed parameters in the signature of a builtin.
+#define LNATIVE_MAX_PARAMS 8
+
+// Type of a signature parameter accepting q-expressions, arrays and vectors.
+#define LNATIVE_LIST -2
+
+// Type of a signature parameter accepting both strings and ropes.
+#define LNATIVE_TEXT -3
+
 #define LASSERT(args, cond, fmt, ...) \
   if (!(cond)) { \
     lval_t *err = lval_err(fmt, ##__VA_ARGS__); \
@@ -46,38 +68,153 @@
 
 typedef struct lval_s lval_t;
 typedef struct lenv_s lenv_t;
+typedef struct lmemo_s lmemo_t;
+typedef struct llambda_s llambda_t;
+typedef struct lcells_s lcells_t;
+typedef struct lseq_s lseq_t;
+typedef struct lvec_s lvec_t;
+typedef struct lmap_s lmap_t;
+typedef struct ltable_s ltable_t;
 
 typedef lval_t *(*lbuiltin)(lenv_t *, lval_t *);
 
+// Builtin taking its arguments as an array. Arguments are borrowed: the caller
+// frees them, unless the builtin takes one by replacing it with NULL in the array.
+typedef lval_t *(*lbuiltin_argv)(lenv_t *, lval_t **, size_t);
+
 typedef enum
 {
   NUMBER,
+  // Integer too large for a `long`, never holds a value that fits one.
+  BIGNUM,
+  FLOAT,
   STRING,
   SYMBOL,
   FUN,
   SEXPR,
   QEXPR,
+  // Packed numbers, see `larray_t`.
+  ARRAY,
+  // Elements computed on demand, see `lseq_t`.
+  LAZY,
+  // Persistent vector, see `lvec_t`.
+  VECTOR,
+  // Persistent hash map, see `lmap_t`.
+  MAP,
+  // Mutable hash table, see `ltable_t`.
+  TABLE,
+  // Long string, see `lrope_t`.
+  ROPE,
+  // Mutable string, see `lbuilder_t`.
+  BUILDER,
   ERROR,
 } lval_type_t;
 
+// A builtin using the array calling convention, along with the signature
+// its arguments are checked against before it is called.
+typedef struct
+{
+  const char *name;
+  lbuiltin_argv function;
+
+  // One character per parameter: `n`umber, `s`tring, s`y`mbol, `f`unction,
+  // `q`-expression, `a`rray, `v`ector, `m`ap, hash `t`able, string `b`uilder,
+  // `l`ist for a q-expression, an array or a vector, te`x`t for a string or a rope,
+  // or `.` for any type.
+  // A trailing `*` repeats the last one.
+  const char *signature;
+
+  // Parsed from the signature when the builtin is registered.
+  size_t arity;
+  bool variadic;
+  int types[LNATIVE_MAX_PARAMS];
+} lnative_t;
+
 // Used to store any d-lisp value;
 typedef struct lval_s
 {
   lval_type_t type;
 
-  long number;
-  char *string;
-  char *symbol;
-  char *error;
+  // Only the fields of the type of the value are set.
+  union {
+    long number;
+    lbig_t *big;
+    double real;
+    larray_t *array;
+    lseq_t *seq;
+    lvec_t *vector;
+    lmap_t *map;
+    ltable_t *table;
+    lrope_t *rope;
+    lbuilder_t *builder;
+    lstr_t *string;
+    char *error;
 
-  lbuiltin builtin;
-  lenv_t *env;
-  lval_t *formals;
-  lval_t *body;
+    // Points to `inline_symbol` while the symbol fits it.
+    struct {
+      char *symbol;
+      char inline_symbol[LVAL_INLINE_SYMBOL];
+    };
+
+    // Expressions and functions.
+    struct {
+      // Set for builtins, depending on their calling convention, or for lambdas.
+      lbuiltin builtin;
+      const lnative_t *native;
+      llambda_t *lambda;
+
+      // Children of an expression, or the arguments already given to a partially
+      // applied lambda. Points to `inline_cell` while they fit, see `lval_resize_cells`.
+      size_t count;
+      lval_t **cell;
+
+      // Set when `cell` is a view into cells shared with other q-expressions.
+      // Shared cells are never modified, see `lval_unshare`.
+      lcells_t *shared;
+
+      lval_t *inline_cell[LVAL_INLINE_CELLS];
+    };
+  };
+} lval_t;
 
+// Children of a q-expression, shared by its clones and the slices taken from it.
+struct lcells_s {
+  size_t refs;
   size_t count;
   lval_t **cell;
-} lval_t;
+
+  // Cached `lval_hash` of the views of all the cells, 0 until it is computed.
+  size_t hash;
+
+  // Set for the cells of an interned literal, see `lval_intern`.
+  bool interned;
+};
+
+// Global names something was computed from, as of the `lenv_generation`
+// it was computed at. It has to be computed again once one of them is rebound.
+// Scoping is dynamic: a caller binding one of them locally changes it as well.
+typedef struct
+{
+  size_t generation;
+  size_t count;
+  char **names;
+} ldeps_t;
+
+// Code of a lambda. It never changes once created, so it is shared by
+// every clone of the lambda along with the state attached to it.
+struct llambda_s {
+  size_t refs;
+  lval_t *formals;
+  lval_t *body;
+
+  // Result cache of a memoized recipe, NULL otherwise.
+  lmemo_t *memo;
+
+  // Body with small recipes inlined, NULL if there was nothing to inline,
+  // and the names of the recipes it was inlined from.
+  lval_t *inlined;
+  ldeps_t deps;
+};
 
 // Used to keep track of the variables names and their associated lval.
 struct lenv_s {
@@ -86,36 +223,72 @@ struct lenv_s {
   size_t count;
   char **syms;
   lval_t **vals;
+
+  // Global environment only: the `lenv_generation` each binding last changed at.
+  size_t *stamps;
 };
 
+// Incremented every time a binding of the global environment changes.
+extern size_t lenv_generation;
+
+// Whether equal q-expression literals read from the source share a single copy.
+extern bool lval_intern_literals;
+
 lenv_t *lenv_new(sep_t *);
 lval_t *lval_num(long);
+lval_t *lval_big(lbig_t *);
+lval_t *lval_float(double);
+lval_t *lval_array(larray_t *);
+lval_t *lval_lazy(lseq_t *);
+lval_t *lval_vector(lvec_t *);
+lval_t *lval_map(lmap_t *);
+lval_t *lval_table(ltable_t *);
+lval_t *lval_rope(lrope_t *);
+lval_t *lval_builder(lbuilder_t *);
 lval_t *lval_string(const char *);
+lval_t *lval_string_n(const char *, size_t);
 lval_t *lval_sym(const char *);
+lval_t *lval_nil(void);
+lval_t *lval_empty(void);
+lval_t *lval_bool(bool);
+bool lval_is_immortal(const lval_t *);
 lval_t *lval_sexpr();
 lval_t *lval_qexpr();
 lval_t *lval_fun(lbuiltin);
+lval_t *lval_native(const lnative_t *);
 lval_t *lval_lambda(lenv_t *, lval_t *, lval_t *);
+llambda_t *llambda_new(lval_t *, lval_t *);
+llambda_t *llambda_ref(llambda_t *);
+void llambda_unref(llambda_t *);
 lval_t *lval_err(const char *, ...);
 
 lval_t *lenv_get(lenv_t *, const char *);
+lval_t *lenv_peek(lenv_t *, const char *);
+size_t lenv_stamp(lenv_t *, const char *);
 void lenv_push(lenv_t *, lval_t *, lval_t *);
 void lenv_def(lenv_t *, lval_t *, lval_t *);
 void lenv_add_builtin(lenv_t *, const char *, lbuiltin);
+void lenv_add_native(lenv_t *, lnative_t *);
 void lenv_add_builtins(lenv_t *);
 
 lval_t *lval_read_num(const mpc_ast_t *);
 lval_t *lval_read(const mpc_ast_t *);
+void lval_literals_del(void);
 lval_t *lval_add(lval_t *, lval_t *);
 lval_t *lval_pop(lval_t *, unsigned int);
 lval_t *lval_take(lval_t *, unsigned int);
+void lval_unshare(lval_t *);
 
 lval_t *lval_eval(lenv_t *, lval_t *);
 lval_t *lval_eval_sexpr(lenv_t *, lval_t *);
 lval_t *lval_call(lenv_t *, lval_t *, lval_t *);
+lval_t *lval_call_argv(lenv_t *, const lval_t *, lval_t **, size_t);
 int lval_eq(lval_t *, lval_t *);
+size_t lval_hash(const lval_t *);
+bool lval_hashable(const lval_t *);
 int lval_cmp(lval_t *, lval_t *);
 lval_t *builtin_op(lenv_t *, lval_t *, char *);
+bool lval_op_apply(const char *, long *, long);
 lval_t *builtin_op_add(lenv_t *, lval_t *);
 lval_t *builtin_op_sub(lenv_t *, lval_t *);
 lval_t *builtin_op_div(lenv_t *, lval_t *);
@@ -128,20 +301,84 @@ lval_t *builtin_op_lesser_equal(lenv_t *, lval_t *);
 lval_t *builtin_cmp(lenv_t *, lval_t *, const char *);
 lval_t *builtin_cmp_eq(lenv_t *, lval_t *);
 lval_t *builtin_cmp_neq(lenv_t *, lval_t *);
-lval_t *builtin_head(lenv_t *, lval_t *);
-lval_t *builtin_tail(lenv_t *, lval_t *);
+lval_t *builtin_head(lenv_t *, lval_t **, size_t);
+lval_t *builtin_tail(lenv_t *, lval_t **, size_t);
 lval_t *builtin_list(lenv_t *, lval_t *);
-lval_t *builtin_eval(lenv_t *, lval_t *);
-lval_t *builtin_join(lenv_t *, lval_t *);
+lval_t *builtin_eval(lenv_t *, lval_t **, size_t);
+lval_t *builtin_join(lenv_t *, lval_t **, size_t);
 lval_t *builtin_var(lenv_t *, lval_t *, const char *);
 lval_t *builtin_def(lenv_t *, lval_t *);
 lval_t *builtin_push(lenv_t *, lval_t *);
 lval_t *builtin_lambda(lenv_t *, lval_t *);
+lval_t *builtin_define_fn(lenv_t *, lval_t *, const char *, size_t);
 lval_t *builtin_fn(lenv_t *, lval_t *);
+lval_t *builtin_memo_fn(lenv_t *, lval_t *);
+lval_t *builtin_memo_clear(lenv_t *, lval_t **, size_t);
+lval_t *builtin_memo_stats(lenv_t *, lval_t **, size_t);
+lval_t *builtin_pure(lenv_t *, lval_t **, size_t);
+lval_t *builtin_effect(lenv_t *, lval_t **, size_t);
 lval_t *builtin_if(lenv_t *, lval_t *);
+lval_t *builtin_loop(lenv_t *, lval_t *);
+lval_t *builtin_recur(lenv_t *, lval_t *);
 lval_t *builtin_load(lenv_t *, lval_t *);
-lval_t *builtin_print(lenv_t *, lval_t *);
-lval_t *builtin_error(lenv_t *, lval_t *);
+lval_t *builtin_print(lenv_t *, lval_t **, size_t);
+lval_t *builtin_error(lenv_t *, lval_t **, size_t);
+lval_t *builtin_map(lenv_t *, lval_t **, size_t);
+lval_t *builtin_filter(lenv_t *, lval_t **, size_t);
+lval_t *builtin_fold_left(lenv_t *, lval_t **, size_t);
+lval_t *builtin_fold_right(lenv_t *, lval_t **, size_t);
+lval_t *builtin_for_each(lenv_t *, lval_t **, size_t);
+lval_t *builtin_pack(lenv_t *, lval_t **, size_t);
+lval_t *builtin_unpack(lenv_t *, lval_t **, size_t);
+lval_t *builtin_length(lenv_t *, lval_t **, size_t);
+lval_t *builtin_nth(lenv_t *, lval_t **, size_t);
+lval_t *builtin_last(lenv_t *, lval_t **, size_t);
+lval_t *builtin_slice(lenv_t *, lval_t **, size_t);
+lval_t *builtin_reverse(lenv_t *, lval_t **, size_t);
+lval_t *builtin_range(lenv_t *, lval_t **, size_t);
+lval_t *builtin_iterate(lenv_t *, lval_t **, size_t);
+lval_t *builtin_take(lenv_t *, lval_t **, size_t);
+lval_t *builtin_drop(lenv_t *, lval_t **, size_t);
+lval_t *builtin_lazy_map(lenv_t *, lval_t **, size_t);
+lval_t *builtin_lazy_filter(lenv_t *, lval_t **, size_t);
+lval_t *builtin_force(lenv_t *, lval_t **, size_t);
+lval_t *builtin_mapping(lenv_t *, lval_t **, size_t);
+lval_t *builtin_filtering(lenv_t *, lval_t **, size_t);
+lval_t *builtin_comp(lenv_t *, lval_t **, size_t);
+lval_t *builtin_transduce(lenv_t *, lval_t **, size_t);
+lval_t *builtin_vector(lenv_t *, lval_t **, size_t);
+lval_t *builtin_vec(lenv_t *, lval_t **, size_t);
+lval_t *builtin_conj(lenv_t *, lval_t **, size_t);
+lval_t *builtin_assoc(lenv_t *, lval_t **, size_t);
+lval_t *builtin_dict(lenv_t *, lval_t **, size_t);
+lval_t *builtin_get(lenv_t *, lval_t **, size_t);
+lval_t *builtin_dissoc(lenv_t *, lval_t **, size_t);
+lval_t *builtin_keys(lenv_t *, lval_t **, size_t);
+lval_t *builtin_merge(lenv_t *, lval_t **, size_t);
+lval_t *builtin_hash(lenv_t *, lval_t **, size_t);
+lval_t *builtin_ht_new(lenv_t *, lval_t **, size_t);
+lval_t *builtin_ht_put(lenv_t *, lval_t **, size_t);
+lval_t *builtin_ht_get(lenv_t *, lval_t **, size_t);
+lval_t *builtin_ht_update(lenv_t *, lval_t **, size_t);
+lval_t *builtin_ht_count(lenv_t *, lval_t **, size_t);
+lval_t *builtin_ht_entries(lenv_t *, lval_t **, size_t);
+lval_t *builtin_concat(lenv_t *, lval_t **, size_t);
+lval_t *builtin_substr(lenv_t *, lval_t **, size_t);
+lval_t *builtin_str_len(lenv_t *, lval_t **, size_t);
+lval_t *builtin_str_split(lenv_t *, lval_t **, size_t);
+lval_t *builtin_sb_new(lenv_t *, lval_t **, size_t);
+lval_t *builtin_sb_append(lenv_t *, lval_t **, size_t);
+lval_t *builtin_sb_build(lenv_t *, lval_t **, size_t);
+lval_t *builtin_sum(lenv_t *, lval_t **, size_t);
+lval_t *builtin_smallest(lenv_t *, lval_t **, size_t);
+lval_t *builtin_biggest(lenv_t *, lval_t **, size_t);
+lval_t *builtin_dot(lenv_t *, lval_t **, size_t);
+lval_t *builtin_array_add(lenv_t *, lval_t **, size_t);
+lval_t *builtin_array_sub(lenv_t *, lval_t **, size_t);
+lval_t *builtin_array_mul(lenv_t *, lval_t **, size_t);
+lval_t *builtin_array_eq(lenv_t *, lval_t **, size_t);
+lval_t *builtin_array_lt(lenv_t *, lval_t **, size_t);
+lval_t *builtin_array_gt(lenv_t *, lval_t **, size_t);
 
 void lval_println(lval_t *);
 void lval_print_string(const lval_t *);
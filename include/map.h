@@ -0,0 +1,59 @@
+#ifndef MAP_H_
+#define MAP_H_
+
+#include <stdint.h>
+#include "lval.h"
+
+// Each level of a map consumes LMAP_BITS bits of the hash of a key.
+#define LMAP_BITS 5
+#define LMAP_MASK ((1 << LMAP_BITS) - 1)
+
+// Keys whose hashes are equal on all their bits end up in a collision node.
+#define LMAP_HASH_BITS (sizeof(size_t) * CHAR_BIT)
+
+typedef struct lmap_node_s lmap_node_t;
+
+// Key and value, or a child node when `key` is NULL.
+typedef struct
+{
+  size_t hash;
+  lval_t *key;
+  lval_t *value;
+  lmap_node_t *node;
+} lmap_entry_t;
+
+// Node of a hash array mapped trie, shared by every version of the map that did not
+// modify it. Nodes are only modified in place while nothing else refers to them.
+struct lmap_node_s
+{
+  size_t refs;
+
+  // Bit `i` is set when the node has an entry for keys whose hash has the value `i` at
+  // its level. Its entries are sorted by that value. Unused by collision nodes.
+  uint32_t bitmap;
+
+  size_t count;
+  lmap_entry_t *entries;
+};
+
+// Persistent hash map, from any value but functions and lazy sequences.
+struct lmap_s
+{
+  size_t count;
+  lmap_node_t *root;
+};
+
+typedef void (*lmap_visit_t)(const lval_t *key, const lval_t *value, void *data);
+
+lmap_t *lmap_new(void);
+lmap_t *lmap_clone(const lmap_t *);
+void lmap_del(lmap_t *);
+
+lval_t *lmap_get(const lmap_t *, const lval_t *);
+void lmap_assoc(lmap_t *, lval_t *, lval_t *);
+void lmap_dissoc(lmap_t *, const lval_t *);
+void lmap_each(const lmap_t *, lmap_visit_t, void *);
+
+bool lmap_eq(const lmap_t *, const lmap_t *);
+
+#endif // MAP_H_
@@ -0,0 +1,55 @@
+#ifndef MEMO_H_
+#define MEMO_H_
+
+#include "lval.h"
+#include "effect.h"
+
+// Number of results kept by a memoized recipe when no capacity is given.
+#define MEMO_DEFAULT_CAPACITY 1024
+
+typedef struct lmemo_entry_s lmemo_entry_t;
+
+// A cached call: the arguments it was made with and the value it returned.
+struct lmemo_entry_s
+{
+  size_t hash;
+  lval_t *args;
+  lval_t *result;
+
+  // Next entry in the same hash bucket.
+  lmemo_entry_t *chain;
+  // Neighbours in the least recently used list.
+  lmemo_entry_t *prev;
+  lmemo_entry_t *next;
+};
+
+// Bounded LRU cache of the results of a memoized recipe.
+struct lmemo_s
+{
+  size_t capacity;
+  size_t count;
+
+  size_t bucket_count;
+  lmemo_entry_t **buckets;
+
+  // Most and least recently used entries.
+  lmemo_entry_t *head;
+  lmemo_entry_t *tail;
+
+  size_t hits;
+  size_t misses;
+
+  // Effect of the recipe, and the names it looks up.
+  leffect_t effect;
+  ldeps_t deps;
+};
+
+lmemo_t *lmemo_new(size_t);
+void lmemo_del(lmemo_t *);
+
+lval_t *lmemo_get(lmemo_t *, lval_t *);
+void lmemo_put(lmemo_t *, lval_t *, lval_t *);
+void lmemo_clear(lmemo_t *);
+bool lmemo_sync(lmemo_t *, lenv_t *, lval_t *);
+
+#endif // MEMO_H_
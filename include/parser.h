@@ -6,6 +6,7 @@
 // S-expression parser.
 typedef struct sep_s
 {
+  mpc_parser_t *floating;
   mpc_parser_t *number;
   mpc_parser_t *string;
   mpc_parser_t *symbol;
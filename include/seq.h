@@ -0,0 +1,51 @@
+#ifndef SEQ_H_
+#define SEQ_H_
+
+#include "lval.h"
+
+typedef enum
+{
+  LSEQ_RANGE,
+  LSEQ_ITERATE,
+  LSEQ_LIST,
+  LSEQ_TAKE,
+  LSEQ_DROP,
+  LSEQ_MAP,
+  LSEQ_FILTER,
+} lseq_kind_t;
+
+// Sequence whose elements are only computed when they are pulled with `lseq_next`.
+// Pulling an element advances the sequence, so every lval owns its own.
+struct lseq_s
+{
+  lseq_kind_t kind;
+
+  // Next number and bound of a range, position in a list,
+  // or how many elements are left to take or to drop.
+  long number;
+  long end;
+  long step;
+
+  // Last element of `iterate`, or the q-expression of a list.
+  lval_t *value;
+  // Set once `iterate` returned `value`, the next element is `fun` applied to it.
+  bool pending;
+
+  // Function of `iterate`, `lazy-map` and `lazy-filter`.
+  lval_t *fun;
+
+  // Sequence transformed by `take`, `drop`, `lazy-map` and `lazy-filter`.
+  lseq_t *source;
+};
+
+lseq_t *lseq_range(long, long, long);
+lseq_t *lseq_iterate(lval_t *, lval_t *);
+lseq_t *lseq_list(lval_t *);
+lseq_t *lseq_wrap(lseq_kind_t, lseq_t *, long, lval_t *);
+lseq_t *lseq_clone(const lseq_t *);
+void lseq_del(lseq_t *);
+
+bool lseq_bounded(const lseq_t *);
+lval_t *lseq_next(lenv_t *, lseq_t *);
+
+#endif // SEQ_H_
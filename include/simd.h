@@ -0,0 +1,52 @@
+#ifndef SIMD_H_
+#define SIMD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum
+{
+  LSIMD_EQ,
+  LSIMD_LT,
+  LSIMD_GT,
+} lsimd_cmp_t;
+
+// Kernels over packed arrays, for one instruction set.
+// Integer kernels returning a bool return false when a result overflows.
+// Comparisons write a mask of 1 and 0.
+typedef struct
+{
+  const char *name;
+
+  bool (*sum_int)(const int64_t *, size_t, int64_t *);
+  double (*sum_float)(const double *, size_t);
+  int64_t (*min_int)(const int64_t *, size_t);
+  int64_t (*max_int)(const int64_t *, size_t);
+  double (*min_float)(const double *, size_t);
+  double (*max_float)(const double *, size_t);
+  bool (*dot_int)(const int64_t *, const int64_t *, size_t, int64_t *);
+  double (*dot_float)(const double *, const double *, size_t);
+
+  bool (*add_int)(int64_t *, const int64_t *, const int64_t *, size_t);
+  bool (*sub_int)(int64_t *, const int64_t *, const int64_t *, size_t);
+  bool (*mul_int)(int64_t *, const int64_t *, const int64_t *, size_t);
+  void (*add_float)(double *, const double *, const double *, size_t);
+  void (*sub_float)(double *, const double *, const double *, size_t);
+  void (*mul_float)(double *, const double *, const double *, size_t);
+
+  void (*cmp_int)(int64_t *, const int64_t *, const int64_t *, size_t, lsimd_cmp_t);
+  void (*cmp_float)(int64_t *, const double *, const double *, size_t, lsimd_cmp_t);
+} lsimd_t;
+
+extern const lsimd_t lsimd_scalar;
+
+#if defined(__x86_64__)
+extern const lsimd_t lsimd_sse2;
+extern const lsimd_t lsimd_avx2;
+#endif
+
+bool lsimd_supported(const lsimd_t *);
+const lsimd_t *lsimd_best(void);
+
+#endif // SIMD_H_
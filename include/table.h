@@ -0,0 +1,50 @@
+#ifndef TABLE_H_
+#define TABLE_H_
+
+#include <stdint.h>
+#include "lval.h"
+
+// Capacity of a table with no expected size.
+#define LTABLE_MIN_CAPACITY 8
+
+// A table grows once more than 7/8th of its slots are used.
+#define LTABLE_LOAD_NUM 7
+#define LTABLE_LOAD_DEN 8
+
+// Key or value of a slot: a number that fits in 63 bits, shifted left with the lowest bit set,
+// or a pointer to any other value. Numbers are the most common keys and values (counters, ids),
+// storing them in the slot saves two lval_t per entry.
+typedef uintptr_t ltable_word_t;
+
+// Key and value of a table, the slot is empty when `key` is 0.
+typedef struct
+{
+  size_t hash;
+  ltable_word_t key;
+  ltable_word_t value;
+} ltable_slot_t;
+
+// Mutable hash table with open addressing. Collisions are resolved by linear probing,
+// keeping entries sorted by their distance to their ideal slot (Robin Hood hashing),
+// so lookups stay short even when the table is almost full.
+// Unlike other values, clones refer to the same table: changes are seen by all of them.
+struct ltable_s
+{
+  size_t refs;
+  size_t count;
+
+  // Power of two.
+  size_t capacity;
+  ltable_slot_t *slots;
+};
+
+ltable_t *ltable_new(size_t);
+ltable_t *ltable_ref(ltable_t *);
+void ltable_unref(ltable_t *);
+
+lval_t *ltable_unpack(ltable_word_t);
+
+lval_t *ltable_get(const ltable_t *, const lval_t *);
+void ltable_put(ltable_t *, lval_t *, lval_t *);
+
+#endif // TABLE_H_
@@ -0,0 +1,78 @@
+#ifndef TEXT_H_
+#define TEXT_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// Concatenations up to this length are copied into a single leaf.
+#define LROPE_LEAF_MAX 256
+
+// Ropes deeper than this are rebalanced.
+#define LROPE_MAX_DEPTH 48
+
+typedef struct lstr_s lstr_t;
+typedef struct lrope_s lrope_t;
+typedef struct lbuilder_s lbuilder_t;
+
+// Immutable string prefixed with its length, shared by the clones of a string lval.
+// It may hold NUL bytes, and is followed by one for the C functions expecting it.
+struct lstr_s
+{
+  size_t refs;
+  size_t length;
+
+  // Cached `lval_hash` of the string, 0 until it is computed.
+  size_t hash;
+
+  char text[];
+};
+
+// Immutable string made of the concatenation of two ropes, or of a leaf of text.
+// Nodes are shared by every rope built from them.
+struct lrope_s
+{
+  size_t refs;
+  size_t length;
+
+  // 0 for a leaf.
+  unsigned int depth;
+
+  // Children of a concatenation, NULL for a leaf.
+  lrope_t *left;
+  lrope_t *right;
+
+  // Text of a leaf, not NUL-terminated.
+  char text[];
+};
+
+// Mutable string appended to in place. Like hash tables, its clones refer to the same builder.
+struct lbuilder_s
+{
+  size_t refs;
+  size_t length;
+  size_t capacity;
+  char *text;
+};
+
+lstr_t *lstr_new(const char *, size_t);
+lstr_t *lstr_ref(lstr_t *);
+void lstr_unref(lstr_t *);
+bool lstr_eq(const lstr_t *, const lstr_t *);
+
+lrope_t *lrope_leaf(const char *, size_t);
+lrope_t *lrope_ref(lrope_t *);
+void lrope_unref(lrope_t *);
+
+lrope_t *lrope_concat(lrope_t *, lrope_t *);
+lrope_t *lrope_sub(lrope_t *, size_t, size_t);
+void lrope_copy(const lrope_t *, char *);
+char *lrope_flatten(const lrope_t *);
+
+lbuilder_t *lbuilder_new(size_t);
+lbuilder_t *lbuilder_ref(lbuilder_t *);
+void lbuilder_unref(lbuilder_t *);
+void lbuilder_append(lbuilder_t *, const char *, size_t);
+void lbuilder_append_rope(lbuilder_t *, const lrope_t *);
+
+#endif // TEXT_H_
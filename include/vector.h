@@ -0,0 +1,52 @@
+#ifndef VECTOR_H_
+#define VECTOR_H_
+
+#include "lval.h"
+
+// Each node of a vector has 2^LVEC_BITS children.
+#define LVEC_BITS 5
+#define LVEC_WIDTH (1 << LVEC_BITS)
+#define LVEC_MASK (LVEC_WIDTH - 1)
+
+typedef struct lvec_node_s lvec_node_t;
+
+// Node of the trie of a vector, shared by every version of it that did not modify it.
+// Nodes are only modified in place while nothing else refers to them.
+struct lvec_node_s
+{
+  size_t refs;
+
+  union {
+    // Children of an inner node.
+    lvec_node_t *children[LVEC_WIDTH];
+    // Elements of a leaf, owned by it.
+    lval_t *values[LVEC_WIDTH];
+  };
+};
+
+// Persistent vector: a trie of leaves of LVEC_WIDTH elements indexed by the bits
+// of the index, LVEC_BITS at a time, along with the last leaf kept aside as a tail
+// so that appending only touches the trie once every LVEC_WIDTH elements.
+struct lvec_s
+{
+  size_t count;
+
+  // Bits of the index below the ones selecting a child of the root.
+  unsigned int shift;
+
+  // NULL while the vector fits in its tail.
+  lvec_node_t *root;
+  lvec_node_t *tail;
+};
+
+lvec_t *lvec_new(void);
+lvec_t *lvec_clone(const lvec_t *);
+void lvec_del(lvec_t *);
+
+lval_t *lvec_nth(const lvec_t *, size_t);
+void lvec_conj(lvec_t *, lval_t *);
+void lvec_assoc(lvec_t *, size_t, lval_t *);
+
+bool lvec_eq(const lvec_t *, const lvec_t *);
+
+#endif // VECTOR_H_
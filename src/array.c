@@ -0,0 +1,62 @@
+#include <string.h>
+#include "array.h"
+
+//  --------------
+// | Constructors |
+//  --------------
+
+/// @brief Return a new array with uninitialized elements.
+/// @param kind type of the elements.
+/// @param count number of elements.
+larray_t *larray_new(larray_kind_t kind, size_t count)
+{
+    larray_t *array = malloc(sizeof(larray_t));
+
+    if (!array)
+        return NULL;
+
+    // aligned_alloc needs a size multiple of the alignment, and a non-empty one.
+    size_t size = (count * sizeof(int64_t) + LARRAY_ALIGNMENT - 1) / LARRAY_ALIGNMENT * LARRAY_ALIGNMENT;
+
+    array->kind = kind;
+    array->count = count;
+    array->ints = aligned_alloc(LARRAY_ALIGNMENT, size ? size : LARRAY_ALIGNMENT);
+
+    return array;
+}
+
+larray_t *larray_clone(const larray_t *array)
+{
+    larray_t *new = larray_new(array->kind, array->count);
+
+    memcpy(new->ints, array->ints, sizeof(int64_t) * array->count);
+
+    return new;
+}
+
+void larray_del(larray_t *array)
+{
+    free(array->ints);
+    free(array);
+}
+
+//  ------------
+// | Comparison |
+//  ------------
+
+bool larray_eq(const larray_t *x, const larray_t *y)
+{
+    if (x->kind != y->kind || x->count != y->count)
+        return false;
+
+    if (x->kind == ARRAY_INT)
+        return memcmp(x->ints, y->ints, sizeof(int64_t) * x->count) == 0;
+
+    // Floats are compared by value, 0.0 and -0.0 are equal.
+    for (size_t i = 0; i < x->count; ++i) {
+        if (x->floats[i] != y->floats[i])
+            return false;
+    }
+
+    return true;
+}
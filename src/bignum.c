@@ -0,0 +1,548 @@
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "bignum.h"
+
+#define LIMB_BASE ((uint64_t)1 << 32)
+
+// Largest power of ten fitting a limb, numbers are read and printed 9 digits at a time.
+#define DECIMAL_CHUNK 1000000000U
+#define DECIMAL_CHUNK_DIGITS 9
+
+//  ------------
+// | Magnitudes |
+//  ------------
+
+// Length of a magnitude without its leading zero limbs.
+static size_t mag_trim(const uint32_t *a, size_t an)
+{
+    while (an && !a[an - 1])
+        an--;
+
+    return an;
+}
+
+static int mag_cmp(const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
+{
+    an = mag_trim(a, an);
+    bn = mag_trim(b, bn);
+
+    if (an != bn)
+        return an < bn ? -1 : 1;
+
+    for (size_t i = an; i-- > 0;) {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+
+    return 0;
+}
+
+// r = a + b, r has room for max(an, bn) + 1 limbs and may alias a or b.
+static size_t mag_add(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
+{
+    if (an < bn)
+        return mag_add(r, b, bn, a, an);
+
+    uint64_t carry = 0;
+
+    for (size_t i = 0; i < an; ++i)
+    {
+        carry += (uint64_t)a[i] + (i < bn ? b[i] : 0);
+        r[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+
+    r[an] = (uint32_t)carry;
+
+    return an + 1;
+}
+
+// r = a - b where a >= b, r has room for an limbs and may alias a.
+static void mag_sub(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
+{
+    int64_t borrow = 0;
+
+    bn = mag_trim(b, bn);
+
+    for (size_t i = 0; i < an; ++i)
+    {
+        int64_t diff = (int64_t)a[i] - (i < bn ? b[i] : 0) - borrow;
+
+        borrow = diff < 0;
+        r[i] = (uint32_t)(diff + (borrow ? (int64_t)LIMB_BASE : 0));
+    }
+}
+
+// r += t, where the sum is known to fit in rn limbs.
+static void mag_add_into(uint32_t *r, size_t rn, const uint32_t *t, size_t tn)
+{
+    uint64_t carry = 0;
+
+    tn = mag_trim(t, tn);
+
+    for (size_t i = 0; i < rn && (i < tn || carry); ++i)
+    {
+        carry += (uint64_t)r[i] + (i < tn ? t[i] : 0);
+        r[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+}
+
+// r = a * b, r has room for an + bn limbs and is zeroed by the caller.
+static void mag_mul_schoolbook(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
+{
+    for (size_t i = 0; i < an; ++i)
+    {
+        uint64_t carry = 0;
+
+        for (size_t j = 0; j < bn; ++j)
+        {
+            carry += (uint64_t)a[i] * b[j] + r[i + j];
+            r[i + j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+
+        r[i + bn] = (uint32_t)carry;
+    }
+}
+
+/// @brief Multiply two magnitudes with Karatsuba's algorithm: splitting both
+///        operands in halves `x1 B^m + x0`, the middle product is computed as
+///        `(a0 + a1)(b0 + b1) - a0 b0 - a1 b1`, three multiplications instead of four.
+/// @param r result, with room for an + bn limbs and zeroed by the caller.
+static void mag_mul(uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
+{
+    if (an < bn) {
+        mag_mul(r, b, bn, a, an);
+        return;
+    }
+
+    if (bn < LBIG_KARATSUBA_THRESHOLD) {
+        mag_mul_schoolbook(r, a, an, b, bn);
+        return;
+    }
+
+    size_t m = (an + 1) / 2;
+
+    // Unbalanced operands: multiply each half of a by the whole of b.
+    if (bn <= m)
+    {
+        uint32_t *high = calloc(an - m + bn, sizeof(uint32_t));
+
+        mag_mul(r, a, m, b, bn);
+        mag_mul(high, a + m, an - m, b, bn);
+        mag_add_into(r + m, an + bn - m, high, an - m + bn);
+        free(high);
+
+        return;
+    }
+
+    // z0 = a0 b0 and z2 = a1 b1 go straight to their place in r.
+    mag_mul(r, a, m, b, m);
+    mag_mul(r + 2 * m, a + m, an - m, b + m, bn - m);
+
+    uint32_t *sa = malloc(sizeof(uint32_t) * (m + 1));
+    uint32_t *sb = malloc(sizeof(uint32_t) * (m + 1));
+    size_t san = mag_trim(sa, mag_add(sa, a, m, a + m, an - m));
+    size_t sbn = mag_trim(sb, mag_add(sb, b, m, b + m, bn - m));
+    uint32_t *z1 = calloc(san + sbn, sizeof(uint32_t));
+
+    mag_mul(z1, sa, san, sb, sbn);
+    mag_sub(z1, z1, san + sbn, r, 2 * m);
+    mag_sub(z1, z1, san + sbn, r + 2 * m, an + bn - 2 * m);
+    mag_add_into(r + m, an + bn - m, z1, san + sbn);
+
+    free(sa);
+    free(sb);
+    free(z1);
+}
+
+// q = a / d, return a % d. q has room for an limbs and may alias a.
+static uint32_t mag_divmod_limb(uint32_t *q, const uint32_t *a, size_t an, uint32_t d)
+{
+    uint64_t rem = 0;
+
+    for (size_t i = an; i-- > 0;)
+    {
+        uint64_t cur = (rem << 32) | a[i];
+
+        q[i] = (uint32_t)(cur / d);
+        rem = cur % d;
+    }
+
+    return (uint32_t)rem;
+}
+
+/// @brief Divide two magnitudes with Knuth's algorithm D.
+/// @param q quotient, with room for an - bn + 1 limbs.
+/// @param r remainder, with room for bn limbs.
+/// @param b divisor, trimmed and with at least two limbs, an >= bn.
+static void mag_divmod(uint32_t *q, uint32_t *r, const uint32_t *a, size_t an, const uint32_t *b, size_t bn)
+{
+    // Normalize so that the top limb of the divisor has its high bit set,
+    // which keeps the estimated quotient limbs off by at most two.
+    int s = __builtin_clz(b[bn - 1]);
+    uint32_t *vn = malloc(sizeof(uint32_t) * bn);
+    uint32_t *un = malloc(sizeof(uint32_t) * (an + 1));
+
+    for (size_t i = bn - 1; i > 0; --i)
+        vn[i] = (b[i] << s) | (s ? b[i - 1] >> (32 - s) : 0);
+    vn[0] = b[0] << s;
+
+    un[an] = s ? a[an - 1] >> (32 - s) : 0;
+    for (size_t i = an - 1; i > 0; --i)
+        un[i] = (a[i] << s) | (s ? a[i - 1] >> (32 - s) : 0);
+    un[0] = a[0] << s;
+
+    for (size_t j = an - bn + 1; j-- > 0;)
+    {
+        uint64_t num = ((uint64_t)un[j + bn] << 32) | un[j + bn - 1];
+        uint64_t qhat = num / vn[bn - 1];
+        uint64_t rhat = num % vn[bn - 1];
+
+        while (qhat >= LIMB_BASE || qhat * vn[bn - 2] > ((rhat << 32) | un[j + bn - 2]))
+        {
+            qhat--;
+            rhat += vn[bn - 1];
+
+            if (rhat >= LIMB_BASE)
+                break;
+        }
+
+        // Multiply and subtract, adding back if the estimate was one too large.
+        int64_t borrow = 0;
+        int64_t t;
+
+        for (size_t i = 0; i < bn; ++i)
+        {
+            uint64_t p = qhat * vn[i];
+
+            t = (int64_t)un[i + j] - borrow - (int64_t)(p & 0xFFFFFFFF);
+            un[i + j] = (uint32_t)t;
+            borrow = (int64_t)(p >> 32) - (t >> 32);
+        }
+
+        t = (int64_t)un[j + bn] - borrow;
+        un[j + bn] = (uint32_t)t;
+        q[j] = (uint32_t)qhat;
+
+        if (t < 0)
+        {
+            uint64_t carry = 0;
+
+            q[j]--;
+
+            for (size_t i = 0; i < bn; ++i)
+            {
+                carry += (uint64_t)un[i + j] + vn[i];
+                un[i + j] = (uint32_t)carry;
+                carry >>= 32;
+            }
+
+            un[j + bn] += (uint32_t)carry;
+        }
+    }
+
+    for (size_t i = 0; i < bn; ++i)
+        r[i] = (un[i] >> s) | (s ? un[i + 1] << (32 - s) : 0);
+
+    free(vn);
+    free(un);
+}
+
+//  --------------
+// | Constructors |
+//  --------------
+
+// Return a new zeroed bignum with room for `capacity` limbs.
+static lbig_t *lbig_alloc(size_t capacity)
+{
+    lbig_t *big = calloc(1, sizeof(lbig_t) + sizeof(uint32_t) * capacity);
+
+    if (!big)
+        return NULL;
+
+    big->negative = false;
+    big->count = capacity;
+
+    return big;
+}
+
+// Drop the leading zero limbs of a result, zero is never negative.
+static lbig_t *lbig_trim(lbig_t *big)
+{
+    big->count = mag_trim(big->limbs, big->count);
+
+    if (!big->count)
+        big->negative = false;
+
+    return big;
+}
+
+lbig_t *lbig_from_long(long value)
+{
+    unsigned long magnitude = value < 0 ? -(unsigned long)value : (unsigned long)value;
+    lbig_t *big = lbig_alloc(2);
+
+    big->negative = value < 0;
+    big->limbs[0] = (uint32_t)magnitude;
+    big->limbs[1] = (uint32_t)(magnitude >> 32);
+
+    return lbig_trim(big);
+}
+
+// Read a decimal integer, with an optional leading minus sign.
+lbig_t *lbig_read(const char *digits)
+{
+    bool negative = *digits == '-';
+
+    if (negative)
+        digits++;
+
+    size_t length = strlen(digits);
+    lbig_t *big = lbig_alloc(length / DECIMAL_CHUNK_DIGITS + 2);
+
+    big->count = 0;
+
+    // Multiply by 10^k and add the next k digits.
+    for (size_t i = 0; i < length;)
+    {
+        size_t k = (length - i) % DECIMAL_CHUNK_DIGITS ? (length - i) % DECIMAL_CHUNK_DIGITS : DECIMAL_CHUNK_DIGITS;
+        uint64_t scale = 1;
+        uint64_t carry = 0;
+
+        for (size_t j = 0; j < k; ++j, ++i) {
+            scale *= 10;
+            carry = carry * 10 + (digits[i] - '0');
+        }
+
+        for (size_t j = 0; j < big->count; ++j)
+        {
+            carry += big->limbs[j] * scale;
+            big->limbs[j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+
+        if (carry)
+            big->limbs[big->count++] = (uint32_t)carry;
+    }
+
+    big->negative = negative;
+
+    return lbig_trim(big);
+}
+
+lbig_t *lbig_clone(const lbig_t *big)
+{
+    lbig_t *new = lbig_alloc(big->count);
+
+    new->negative = big->negative;
+    memcpy(new->limbs, big->limbs, sizeof(uint32_t) * big->count);
+
+    return new;
+}
+
+void lbig_del(lbig_t *big)
+{
+    free(big);
+}
+
+//  ------------
+// | Comparison |
+//  ------------
+
+/// @brief Convert a bignum back to a `long`.
+/// @return false if it does not fit.
+bool lbig_to_long(const lbig_t *big, long *out)
+{
+    if (big->count > 2)
+        return false;
+
+    unsigned long magnitude = 0;
+
+    for (size_t i = big->count; i-- > 0;)
+        magnitude = (magnitude << 32) | big->limbs[i];
+
+    if (magnitude > (unsigned long)LONG_MAX + big->negative)
+        return false;
+
+    *out = big->negative ? (long)-magnitude : (long)magnitude;
+
+    return true;
+}
+
+double lbig_to_double(const lbig_t *big)
+{
+    double value = 0;
+
+    for (size_t i = big->count; i-- > 0;)
+        value = value * (double)LIMB_BASE + big->limbs[i];
+
+    return big->negative ? -value : value;
+}
+
+bool lbig_is_zero(const lbig_t *big)
+{
+    return big->count == 0;
+}
+
+int lbig_cmp(const lbig_t *a, const lbig_t *b)
+{
+    if (a->negative != b->negative)
+        return a->negative ? -1 : 1;
+
+    int cmp = mag_cmp(a->limbs, a->count, b->limbs, b->count);
+
+    return a->negative ? -cmp : cmp;
+}
+
+//  ------------
+// | Arithmetic |
+//  ------------
+
+lbig_t *lbig_neg(const lbig_t *big)
+{
+    lbig_t *neg = lbig_clone(big);
+
+    neg->negative = big->count && !big->negative;
+
+    return neg;
+}
+
+// a + b, or a - b when `negate` is set.
+static lbig_t *lbig_add_signed(const lbig_t *a, const lbig_t *b, bool negate)
+{
+    bool b_negative = b->negative != negate;
+
+    if (a->negative == b_negative)
+    {
+        lbig_t *sum = lbig_alloc((a->count > b->count ? a->count : b->count) + 1);
+
+        mag_add(sum->limbs, a->limbs, a->count, b->limbs, b->count);
+        sum->negative = a->negative;
+
+        return lbig_trim(sum);
+    }
+
+    // Signs differ: subtract the smaller magnitude from the larger one.
+    if (mag_cmp(a->limbs, a->count, b->limbs, b->count) < 0)
+    {
+        lbig_t *diff = lbig_alloc(b->count);
+
+        mag_sub(diff->limbs, b->limbs, b->count, a->limbs, a->count);
+        diff->negative = b_negative;
+
+        return lbig_trim(diff);
+    }
+
+    lbig_t *diff = lbig_alloc(a->count);
+
+    mag_sub(diff->limbs, a->limbs, a->count, b->limbs, b->count);
+    diff->negative = a->negative;
+
+    return lbig_trim(diff);
+}
+
+lbig_t *lbig_add(const lbig_t *a, const lbig_t *b)
+{
+    return lbig_add_signed(a, b, false);
+}
+
+lbig_t *lbig_sub(const lbig_t *a, const lbig_t *b)
+{
+    return lbig_add_signed(a, b, true);
+}
+
+lbig_t *lbig_mul(const lbig_t *a, const lbig_t *b)
+{
+    lbig_t *product = lbig_alloc(a->count + b->count);
+
+    mag_mul(product->limbs, a->limbs, a->count, b->limbs, b->count);
+    product->negative = a->negative != b->negative;
+
+    return lbig_trim(product);
+}
+
+/// @brief Divide two bignums, truncating toward zero like C does for `long`.
+/// @param b divisor, must not be zero.
+/// @param rem set to the remainder, which has the sign of a, if not NULL.
+/// @return the quotient.
+lbig_t *lbig_divmod(const lbig_t *a, const lbig_t *b, lbig_t **rem)
+{
+    lbig_t *q;
+    lbig_t *r;
+
+    if (mag_cmp(a->limbs, a->count, b->limbs, b->count) < 0)
+    {
+        q = lbig_alloc(0);
+        r = lbig_clone(a);
+    }
+    else if (b->count == 1)
+    {
+        q = lbig_alloc(a->count);
+        r = lbig_alloc(1);
+        r->limbs[0] = mag_divmod_limb(q->limbs, a->limbs, a->count, b->limbs[0]);
+    }
+    else
+    {
+        q = lbig_alloc(a->count - b->count + 1);
+        r = lbig_alloc(b->count);
+        mag_divmod(q->limbs, r->limbs, a->limbs, a->count, b->limbs, b->count);
+    }
+
+    q->negative = a->negative != b->negative;
+    r->negative = a->negative;
+    lbig_trim(q);
+    lbig_trim(r);
+
+    if (rem)
+        *rem = r;
+    else
+        lbig_del(r);
+
+    return q;
+}
+
+//  ----------
+// | Printing |
+//  ----------
+
+/// @brief Format a bignum in decimal. Digits are produced 9 at a time,
+///        dividing by 10^9 in a single pass over the limbs.
+/// @return a string to be freed by the caller.
+char *lbig_to_string(const lbig_t *big)
+{
+    if (!big->count)
+        return strdup("0");
+
+    size_t count = big->count;
+    uint32_t *magnitude = malloc(sizeof(uint32_t) * count);
+    // A limb holds a bit less than 10 decimal digits, i.e. 32 log10(2) / 9 chunks.
+    uint32_t *chunks = malloc(sizeof(uint32_t) * (count * 32 / 29 + 1));
+    size_t chunk_count = 0;
+
+    memcpy(magnitude, big->limbs, sizeof(uint32_t) * count);
+
+    while (count)
+    {
+        chunks[chunk_count++] = mag_divmod_limb(magnitude, magnitude, count, DECIMAL_CHUNK);
+        count = mag_trim(magnitude, count);
+    }
+
+    char *string = malloc(chunk_count * DECIMAL_CHUNK_DIGITS + 2);
+    char *cursor = string;
+
+    if (big->negative)
+        *cursor++ = '-';
+
+    cursor += sprintf(cursor, "%u", chunks[chunk_count - 1]);
+
+    for (size_t i = chunk_count - 1; i-- > 0;)
+        cursor += sprintf(cursor, "%09u", chunks[i]);
+
+    free(magnitude);
+    free(chunks);
+
+    return string;
+}
@@ -0,0 +1,440 @@
+#include "effect.h"
+
+// Effects of the global recipes analysed since the names they depend on were last
+// rebound, stored like an environment: `cache_effects[i]` is the effect of
+// `cache_syms[i]`, and `cache_deps[i]` the names it was computed from.
+static size_t cache_count = 0;
+static char **cache_syms = NULL;
+static leffect_t *cache_effects = NULL;
+static ldeps_t *cache_deps = NULL;
+
+// Global recipes currently being analysed, used to stop on recursion,
+// and the names looked up by the one on top of the stack.
+typedef struct
+{
+  lenv_t *globals;
+  size_t depth;
+  const char **stack;
+  ldeps_t *deps;
+} leffect_ctx_t;
+
+//  --------------
+// | Dependencies |
+//  --------------
+
+static bool ldeps_has(const ldeps_t *deps, const char *name)
+{
+    for (size_t i = 0; i < deps->count; ++i) {
+        if (strcmp(name, deps->names[i]) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+void ldeps_add(ldeps_t *deps, const char *name)
+{
+    if (ldeps_has(deps, name))
+        return;
+
+    deps->count++;
+    deps->names = realloc(deps->names, sizeof(char *) * deps->count);
+    deps->names[deps->count - 1] = strdup(name);
+}
+
+void ldeps_merge(ldeps_t *deps, const ldeps_t *other)
+{
+    for (size_t i = 0; i < other->count; ++i)
+        ldeps_add(deps, other->names[i]);
+}
+
+void ldeps_clear(ldeps_t *deps)
+{
+    for (size_t i = 0; i < deps->count; ++i)
+        free(deps->names[i]);
+
+    free(deps->names);
+    deps->generation = 0;
+    deps->count = 0;
+    deps->names = NULL;
+}
+
+/// @brief Check whether one of the names was rebound globally since they were looked up.
+///        Names that were never looked up, with a generation of 0, are always stale.
+/// @param env any environment, the global one is found from it.
+bool ldeps_stale(ldeps_t *deps, lenv_t *env)
+{
+    if (deps->generation == lenv_generation)
+        return false;
+
+    if (!deps->generation)
+        return true;
+
+    for (; env->parent; env = env->parent);
+
+    for (size_t i = 0; i < deps->count; ++i) {
+        if (lenv_stamp(env, deps->names[i]) > deps->generation)
+            return true;
+    }
+
+    // Only unrelated names were defined, skip the check until the next definition.
+    deps->generation = lenv_generation;
+
+    return false;
+}
+
+/// @brief Check whether a local environment binds one of the names,
+///        which then no longer refer to their global definition.
+/// @param env environment a recipe is called from.
+bool ldeps_shadowed(const ldeps_t *deps, lenv_t *env)
+{
+    if (!deps->count)
+        return false;
+
+    for (; env->parent; env = env->parent) {
+        for (size_t i = 0; i < env->count; ++i) {
+            if (ldeps_has(deps, env->syms[i]))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+//  -------
+// | Cache |
+//  -------
+
+static void cache_remove(size_t index)
+{
+    free(cache_syms[index]);
+    ldeps_clear(&cache_deps[index]);
+
+    cache_count--;
+    cache_syms[index] = cache_syms[cache_count];
+    cache_effects[index] = cache_effects[cache_count];
+    cache_deps[index] = cache_deps[cache_count];
+}
+
+// Get the effect of a global recipe, and add the names it depends on to `deps`.
+// A result is forgotten once one of these names has been rebound.
+static bool cache_get(lenv_t *globals, const char *sym, leffect_t *effect, ldeps_t *deps)
+{
+    for (size_t i = 0; i < cache_count; ++i) {
+        if (strcmp(sym, cache_syms[i]) == 0) {
+            if (ldeps_stale(&cache_deps[i], globals)) {
+                cache_remove(i);
+                return false;
+            }
+
+            *effect = cache_effects[i];
+            ldeps_merge(deps, &cache_deps[i]);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void cache_put(const char *sym, leffect_t effect, const ldeps_t *deps)
+{
+    cache_count++;
+    cache_syms = realloc(cache_syms, sizeof(char *) * cache_count);
+    cache_effects = realloc(cache_effects, sizeof(leffect_t) * cache_count);
+    cache_deps = realloc(cache_deps, sizeof(ldeps_t) * cache_count);
+
+    cache_syms[cache_count - 1] = strdup(sym);
+    cache_effects[cache_count - 1] = effect;
+    cache_deps[cache_count - 1] = (ldeps_t){0};
+    ldeps_merge(&cache_deps[cache_count - 1], deps);
+    cache_deps[cache_count - 1].generation = lenv_generation;
+}
+
+//  ----------
+// | Analysis |
+//  ----------
+
+static leffect_t effect_join(leffect_t a, leffect_t b)
+{
+    return a > b ? a : b;
+}
+
+static leffect_t effect_of_builtin(const lval_t *fun)
+{
+    lbuiltin builtin = fun->builtin;
+    lbuiltin_argv native = fun->native ? fun->native->function : NULL;
+
+    // `cook` evaluates code only known at runtime.
+    if (native == &builtin_print
+        || builtin == &builtin_def
+        || builtin == &builtin_push
+        || builtin == &builtin_load
+        || builtin == &builtin_fn
+        || builtin == &builtin_memo_fn
+        || native == &builtin_memo_clear
+        || native == &builtin_eval
+        || native == &builtin_ht_put
+        || native == &builtin_ht_update
+        || native == &builtin_sb_append)
+        return EFFECTFUL;
+
+    if (native == &builtin_ht_get
+        || native == &builtin_ht_count
+        || native == &builtin_ht_entries
+        || native == &builtin_sb_build)
+        return READS_STATE;
+
+    return PURE;
+}
+
+static leffect_t effect_of_expr(leffect_ctx_t *, const lval_t *, const lval_t *, size_t *);
+
+/// @brief Analyse a recipe bound in the global environment.
+/// @param low lowest stack index reached through recursion, a result is
+///            only final and cached when it did not depend on a caller
+///            that is still being analysed.
+static leffect_t effect_of_global(leffect_ctx_t *ctx, const char *sym, const lval_t *fun, size_t *low)
+{
+    leffect_t effect;
+
+    if (cache_get(ctx->globals, sym, &effect, ctx->deps))
+        return effect;
+
+    // Recursive calls add nothing to the effect of the recipe being analysed.
+    for (size_t i = 0; i < ctx->depth; ++i) {
+        if (strcmp(sym, ctx->stack[i]) == 0) {
+            *low = i < *low ? i : *low;
+            return PURE;
+        }
+    }
+
+    size_t index = ctx->depth++;
+    size_t own_low = index;
+
+    ctx->stack = realloc(ctx->stack, sizeof(char *) * ctx->depth);
+    ctx->stack[index] = sym;
+
+    // The names of the recipe are gathered apart, to be cached with its effect.
+    // Its own name is one of them, since it can be redefined.
+    ldeps_t *caller_deps = ctx->deps;
+    ldeps_t deps = {0};
+
+    ldeps_add(&deps, sym);
+
+    ctx->deps = &deps;
+    effect = effect_of_expr(ctx, fun->lambda->formals, fun->lambda->body, &own_low);
+    ctx->deps = caller_deps;
+
+    ctx->depth--;
+
+    if (own_low >= index)
+        cache_put(sym, effect, &deps);
+
+    ldeps_merge(ctx->deps, &deps);
+    ldeps_clear(&deps);
+
+    *low = own_low < *low ? own_low : *low;
+
+    return effect;
+}
+
+static bool effect_is_formal(const lval_t *formals, const char *sym)
+{
+    for (size_t i = 0; i < formals->count; ++i) {
+        if (strcmp(sym, formals->cell[i]->symbol) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+// Global function an expression starts with, NULL if it starts with anything else.
+static lval_t *effect_head(leffect_ctx_t *ctx, const lval_t *formals, const lval_t *expr)
+{
+    if (expr->count == 0 || expr->cell[0]->type != SYMBOL || effect_is_formal(formals, expr->cell[0]->symbol))
+        return NULL;
+
+    lval_t *value = lenv_peek(ctx->globals, expr->cell[0]->symbol);
+
+    return value && value->type == FUN ? value : NULL;
+}
+
+/// @brief Analyse a symbol of a recipe body.
+/// @param head true when the symbol is called, e.g. `f` in `(f x)`.
+static leffect_t effect_of_symbol(leffect_ctx_t *ctx, const lval_t *formals, const char *sym, bool head, size_t *low)
+{
+    // Arguments are local, but calling one runs code we know nothing about.
+    if (effect_is_formal(formals, sym))
+        return head ? EFFECTFUL : PURE;
+
+    ldeps_add(ctx->deps, sym);
+
+    lval_t *value = lenv_peek(ctx->globals, sym);
+
+    if (!value)
+        return head ? EFFECTFUL : READS_GLOBALS;
+
+    if (value->type != FUN)
+        return READS_GLOBALS;
+
+    if (!value->lambda)
+        return effect_of_builtin(value);
+
+    return effect_of_global(ctx, sym, value, low);
+}
+
+// Whether a builtin calls one of its arguments, e.g. the function given to `map`.
+// Transducers hold the functions they were built from, `comp` and `transduce` call them.
+static bool effect_calls_arg(const lnative_t *native, size_t index)
+{
+    if (index >= native->arity && !native->variadic)
+        return false;
+
+    int type = native->types[index < native->arity ? index : native->arity - 1];
+
+    return type == FUN
+        || native->function == &builtin_comp
+        || (native->function == &builtin_transduce && index == 0);
+}
+
+// Whether an expression builds a function out of code of the body,
+// e.g. `(improv {x} {add x 1})`, `(mapping inc)` or a partial application.
+static bool effect_builds_fun(leffect_ctx_t *ctx, const lval_t *formals, const lval_t *expr)
+{
+    lval_t *head = effect_head(ctx, formals, expr);
+
+    if (!head)
+        return false;
+
+    if (head->lambda)
+        return expr->count - 1 < head->lambda->formals->count - head->count;
+
+    if (head->native)
+        return head->native->function == &builtin_mapping
+            || head->native->function == &builtin_filtering
+            || head->native->function == &builtin_comp;
+
+    return head->builtin == &builtin_lambda;
+}
+
+/// @brief Analyse an argument a builtin calls, as if it was the head of an expression.
+///        Only functions known from the body can be analysed, anything else,
+///        like an argument of the recipe, runs code we know nothing about.
+static leffect_t effect_of_callee(leffect_ctx_t *ctx, const lval_t *formals, const lval_t *arg, size_t *low)
+{
+    if (arg->type == SYMBOL)
+    {
+        if (effect_is_formal(formals, arg->symbol))
+            return EFFECTFUL;
+
+        ldeps_add(ctx->deps, arg->symbol);
+
+        lval_t *value = lenv_peek(ctx->globals, arg->symbol);
+
+        if (!value || value->type != FUN)
+            return EFFECTFUL;
+
+        return effect_of_symbol(ctx, formals, arg->symbol, true, low);
+    }
+
+    if (arg->type == SEXPR && effect_builds_fun(ctx, formals, arg))
+        return effect_of_expr(ctx, formals, arg, low);
+
+    return EFFECTFUL;
+}
+
+/// @brief Return the formals of a recipe along with the variables of a `loop` it uses,
+///        which are local to the body of the loop. NULL if the loop is malformed.
+/// @param expr the loop, e.g. `(loop {i total} 0 0 {...})`.
+static lval_t *effect_loop_locals(const lval_t *formals, const lval_t *expr)
+{
+    if (expr->count < 3 || expr->cell[1]->type != QEXPR || expr->cell[expr->count - 1]->type != QEXPR)
+        return NULL;
+
+    const lval_t *vars = expr->cell[1];
+    lval_t *locals = lval_qexpr();
+
+    for (size_t i = 0; i < vars->count; ++i)
+    {
+        if (vars->cell[i]->type != SYMBOL) {
+            lval_del(locals);
+            return NULL;
+        }
+
+        lval_add(locals, lval_clone(vars->cell[i]));
+    }
+
+    for (size_t i = 0; i < formals->count; ++i)
+        lval_add(locals, lval_clone(formals->cell[i]));
+
+    return locals;
+}
+
+// Analyse every symbol of an expression. Nested Q-Expressions are
+// analysed as well since they can be evaluated (e.g. `if` branches).
+static leffect_t effect_of_expr(leffect_ctx_t *ctx, const lval_t *formals, const lval_t *expr, size_t *low)
+{
+    leffect_t effect = PURE;
+    lval_t *head = effect_head(ctx, formals, expr);
+    const lnative_t *native = head ? head->native : NULL;
+
+    // The variables of a loop are bound in its body, their initial values are not.
+    lval_t *locals = head && head->builtin == &builtin_loop ? effect_loop_locals(formals, expr) : NULL;
+
+    for (size_t i = 0; i < expr->count && effect != EFFECTFUL; ++i) {
+        const lval_t *child = expr->cell[i];
+
+        if (locals && i == 1)
+            continue;
+
+        if (locals && i == expr->count - 1)
+            effect = effect_join(effect, effect_of_expr(ctx, locals, child, low));
+        else if (i > 0 && native && effect_calls_arg(native, i - 1))
+            effect = effect_join(effect, effect_of_callee(ctx, formals, child, low));
+        else if (child->type == SYMBOL)
+            effect = effect_join(effect, effect_of_symbol(ctx, formals, child->symbol, i == 0 && expr->count > 1, low));
+        else if (child->type == SEXPR || child->type == QEXPR)
+            effect = effect_join(effect, effect_of_expr(ctx, formals, child, low));
+    }
+
+    if (locals)
+        lval_del(locals);
+
+    return effect;
+}
+
+/// @brief Statically classify what calling a function can do.
+///        Results for global recipes are cached until a name they depend on is rebound.
+/// @param env environment the function is called from.
+/// @param fun builtin or lambda to analyse.
+/// @param deps filled with the names the function looks up, NULL if not needed.
+/// @return the effect of the function.
+leffect_t lval_effect(lenv_t *env, lval_t *fun, ldeps_t *deps)
+{
+    if (!fun->lambda)
+        return effect_of_builtin(fun);
+
+    for (; env->parent; env = env->parent);
+
+    ldeps_t scratch = {0};
+    leffect_ctx_t ctx = {.globals = env, .depth = 0, .stack = NULL, .deps = deps ? deps : &scratch};
+    size_t low = 0;
+    leffect_t effect = effect_of_expr(&ctx, fun->lambda->formals, fun->lambda->body, &low);
+
+    free(ctx.stack);
+    ldeps_clear(&scratch);
+
+    return effect;
+}
+
+char *leffect_name(leffect_t effect)
+{
+    switch (effect)
+    {
+      case PURE: return "pure";
+      case READS_GLOBALS: return "reads-globals";
+      case READS_STATE: return "reads-state";
+      case EFFECTFUL: return "effectful";
+      default: return "unknown";
+    }
+}
@@ -0,0 +1,295 @@
+#include "inline.h"
+#include "effect.h"
+
+//  ------------
+// | Heuristics |
+//  ------------
+
+static int formal_index(const lval_t *formals, const char *sym)
+{
+    for (size_t i = 0; i < formals->count; ++i) {
+        if (strcmp(sym, formals->cell[i]->symbol) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+// Count the nodes of an expression.
+static size_t expr_size(const lval_t *expr)
+{
+    if (expr->type != SEXPR && expr->type != QEXPR)
+        return 1;
+
+    size_t size = 1;
+
+    for (size_t i = 0; i < expr->count; ++i)
+        size += expr_size(expr->cell[i]);
+
+    return size;
+}
+
+// Check that an expression only calls builtins. Such a recipe cannot be
+// recursive, and once inlined there is nothing left to inline in it.
+static bool is_leaf(lenv_t *globals, const lval_t *formals, const lval_t *expr)
+{
+    for (size_t i = 0; i < expr->count; ++i)
+    {
+        const lval_t *child = expr->cell[i];
+
+        // Q-Expressions can be evaluated later, or never, which
+        // would change when substituted arguments are evaluated.
+        if (child->type == QEXPR)
+            return false;
+
+        if (child->type == SEXPR && !is_leaf(globals, formals, child))
+            return false;
+
+        if (child->type == SYMBOL && formal_index(formals, child->symbol) < 0)
+        {
+            lval_t *value = lenv_peek(globals, child->symbol);
+
+            if (!value || value->type != FUN || value->lambda)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Record the names looked up by some code, besides its formals.
+static void code_deps(const lval_t *formals, const lval_t *code, ldeps_t *deps)
+{
+    for (size_t i = 0; i < code->count; ++i)
+    {
+        const lval_t *child = code->cell[i];
+
+        if (child->type == SYMBOL && formal_index(formals, child->symbol) < 0)
+            ldeps_add(deps, child->symbol);
+        else if (child->type == SEXPR || child->type == QEXPR)
+            code_deps(formals, child, deps);
+    }
+}
+
+// Count how many times a symbol is used by an expression.
+static size_t symbol_uses(const lval_t *expr, const char *sym)
+{
+    size_t uses = 0;
+
+    for (size_t i = 0; i < expr->count; ++i)
+    {
+        const lval_t *child = expr->cell[i];
+
+        if (child->type == SYMBOL && strcmp(sym, child->symbol) == 0)
+            uses++;
+        else if (child->type == SEXPR)
+            uses += symbol_uses(child, sym);
+    }
+
+    return uses;
+}
+
+// Check that the formals bound to S-Expressions are used in the order
+// they are passed, so that arguments are still evaluated left to right.
+static bool uses_in_order(const lval_t *expr, const lval_t *formals, const lval_t *site, int *last)
+{
+    for (size_t i = 0; i < expr->count; ++i)
+    {
+        const lval_t *child = expr->cell[i];
+
+        if (child->type == SEXPR && !uses_in_order(child, formals, site, last))
+            return false;
+
+        if (child->type != SYMBOL)
+            continue;
+
+        int index = formal_index(formals, child->symbol);
+
+        if (index >= 0 && site->cell[index + 1]->type == SEXPR)
+        {
+            if (index < *last)
+                return false;
+
+            *last = index;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Find the recipe called by a call site, if it can be inlined there.
+/// @param globals global environment.
+/// @param formals formals of the recipe the call site is part of.
+/// @param site call site, e.g. `(increment (add x 1))`.
+/// @param deps filled with the names the decision depends on.
+/// @return the called recipe, or NULL if the call site must be left as is.
+static lval_t *inline_target(lenv_t *globals, const lval_t *formals, const lval_t *site, ldeps_t *deps)
+{
+    if (site->count < 2 || site->cell[0]->type != SYMBOL)
+        return NULL;
+
+    // Arguments of the caller shadow global recipes.
+    if (formal_index(formals, site->cell[0]->symbol) >= 0)
+        return NULL;
+
+    lval_t *callee = lenv_peek(globals, site->cell[0]->symbol);
+
+    if (!callee || callee->type != FUN || !callee->lambda)
+        return NULL;
+
+    llambda_t *lambda = callee->lambda;
+
+    // Redefining anything the recipe calls can change whether it can be inlined.
+    code_deps(lambda->formals, lambda->body, deps);
+
+    // Memoized recipes keep going through their cache, and partial
+    // applications hold arguments the body alone does not have.
+    if (lambda->memo || callee->count || lambda->formals->count != site->count - 1)
+        return NULL;
+
+    if (expr_size(lambda->body) > INLINE_MAX_SIZE
+        || !is_leaf(globals, lambda->formals, lambda->body)
+        || lval_effect(globals, callee, NULL) != PURE)
+        return NULL;
+
+    // A call evaluates each argument exactly once: only values that do not
+    // need to be evaluated can be duplicated or dropped.
+    for (size_t i = 0; i < lambda->formals->count; ++i)
+    {
+        if (site->cell[i + 1]->type == SEXPR
+            && symbol_uses(lambda->body, lambda->formals->cell[i]->symbol) != 1)
+            return NULL;
+    }
+
+    int last = -1;
+
+    return uses_in_order(lambda->body, lambda->formals, site, &last) ? callee : NULL;
+}
+
+//  ----------
+// | Inlining |
+//  ----------
+
+// Clone an expression, replacing the formals of a recipe by the arguments of a call site.
+static lval_t *substitute(lval_t *expr, const lval_t *formals, lval_t *site)
+{
+    lval_t *copy = expr->type == SEXPR ? lval_sexpr() : lval_qexpr();
+
+    for (size_t i = 0; i < expr->count; ++i)
+    {
+        lval_t *child = expr->cell[i];
+        int index = child->type == SYMBOL ? formal_index(formals, child->symbol) : -1;
+
+        if (index >= 0)
+            lval_add(copy, lval_clone(site->cell[index + 1]));
+        else if (child->type == SEXPR)
+            lval_add(copy, substitute(child, formals, site));
+        else
+            lval_add(copy, lval_clone(child));
+    }
+
+    return copy;
+}
+
+// Replace a call site by the body of the called recipe, if possible.
+static bool inline_site(lenv_t *globals, const lval_t *formals, lval_t **site, ldeps_t *deps)
+{
+    lval_t *callee = inline_target(globals, formals, *site, deps);
+
+    if (!callee)
+        return false;
+
+    lval_t *inlined = substitute(callee->lambda->body, callee->lambda->formals, *site);
+
+    inlined->type = (*site)->type;
+    lval_del(*site);
+    *site = inlined;
+
+    return true;
+}
+
+// Check if an expression is a call to the `if` builtin, whose branches are code.
+static bool is_if(lenv_t *globals, const lval_t *formals, const lval_t *expr)
+{
+    if (expr->count != 4 || expr->cell[0]->type != SYMBOL || formal_index(formals, expr->cell[0]->symbol) >= 0)
+        return false;
+
+    lval_t *value = lenv_peek(globals, expr->cell[0]->symbol);
+
+    return value && value->type == FUN && value->builtin == &builtin_if;
+}
+
+// Inline the call sites found in some code, innermost first.
+static bool inline_code(lenv_t *globals, const lval_t *formals, lval_t *code, ldeps_t *deps)
+{
+    bool inlined = false;
+    bool branches = is_if(globals, formals, code);
+
+    lval_unshare(code);
+
+    for (size_t i = 0; i < code->count; ++i)
+    {
+        lval_t *child = code->cell[i];
+
+        // Other Q-Expressions are data, and must be left untouched.
+        if (child->type == SEXPR || (child->type == QEXPR && branches && i >= 2))
+        {
+            inlined |= inline_code(globals, formals, child, deps);
+            inlined |= inline_site(globals, formals, &code->cell[i], deps);
+        }
+    }
+
+    return inlined;
+}
+
+/// @brief Substitute small, non-recursive, pure recipes into the body of a lambda.
+/// @param globals global environment, where called recipes are looked up.
+/// @param lambda lambda to optimize.
+/// @param deps filled with the global names the result depends on.
+/// @return a new body, or NULL if no call site could be inlined.
+lval_t *lval_inline(lenv_t *globals, const llambda_t *lambda, ldeps_t *deps)
+{
+    lval_t *body = lval_clone(lambda->body);
+
+    code_deps(lambda->formals, lambda->body, deps);
+
+    bool inlined = inline_code(globals, lambda->formals, body, deps);
+
+    inlined |= inline_site(globals, lambda->formals, &body, deps);
+
+    if (inlined)
+        return body;
+
+    lval_del(body);
+    return NULL;
+}
+
+/// @brief Get the code to evaluate when calling a lambda. Call sites are
+///        inlined again once a name they depend on has been rebound,
+///        since a called recipe may have been redefined. The plain body
+///        is used while the caller binds one of these names locally.
+/// @param lambda called lambda.
+/// @param env environment the lambda is called from.
+/// @return the body of the lambda, or its inlined version.
+lval_t *llambda_code(llambda_t *lambda, lenv_t *env)
+{
+    if (ldeps_stale(&lambda->deps, env))
+    {
+        lenv_t *globals = env;
+
+        if (lambda->inlined)
+            lval_del(lambda->inlined);
+
+        for (; globals->parent; globals = globals->parent);
+
+        ldeps_clear(&lambda->deps);
+        lambda->inlined = lval_inline(globals, lambda, &lambda->deps);
+        lambda->deps.generation = lenv_generation;
+    }
+
+    // Scoping is dynamic: a caller binding the name of an inlined recipe gets its own function.
+    if (!lambda->inlined || ldeps_shadowed(&lambda->deps, env))
+        return lambda->body;
+
+    return lambda->inlined;
+}
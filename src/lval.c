@@ -1,4 +1,19 @@
 #include "lval.h"
+#include "memo.h"
+#include "effect.h"
+#include "inline.h"
+#include "simd.h"
+#include "seq.h"
+#include "vector.h"
+#include "map.h"
+#include "table.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+size_t lenv_generation = 0;
+bool lval_intern_literals = true;
 
 //  --------------
 // | Constructors |
@@ -18,6 +33,7 @@ lenv_t *lenv_new(sep_t *parser)
     env->count = 0;
     env->syms = NULL;
     env->vals = NULL;
+    env->stamps = NULL;
 
     return env;
 }
@@ -36,6 +52,112 @@ lval_t *lval_num(long value)
     return lval;
 }
 
+// Return a lval with an arbitrary-precision integer,
+// or a number if it fits a `long`. Takes ownership of the bignum.
+lval_t *lval_big(lbig_t *big)
+{
+    long number;
+
+    if (lbig_to_long(big, &number)) {
+        lbig_del(big);
+        return lval_num(number);
+    }
+
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = BIGNUM;
+    lval->big = big;
+
+    return lval;
+}
+
+// Return a lval with a double-precision float.
+lval_t *lval_float(double value)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = FLOAT;
+    lval->real = value;
+
+    return lval;
+}
+
+// Return a lval with a packed array. Takes ownership of the array.
+lval_t *lval_array(larray_t *array)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = ARRAY;
+    lval->array = array;
+
+    return lval;
+}
+
+// Return a lval with a lazy sequence. Takes ownership of the sequence.
+lval_t *lval_lazy(lseq_t *seq)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = LAZY;
+    lval->seq = seq;
+
+    return lval;
+}
+
+// Return a lval with a persistent vector. Takes ownership of the vector.
+lval_t *lval_vector(lvec_t *vector)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = VECTOR;
+    lval->vector = vector;
+
+    return lval;
+}
+
+// Return a lval with a persistent hash map. Takes ownership of the map.
+lval_t *lval_map(lmap_t *map)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = MAP;
+    lval->map = map;
+
+    return lval;
+}
+
+// Return a lval referring to a hash table. Takes ownership of the reference.
+lval_t *lval_table(ltable_t *table)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = TABLE;
+    lval->table = table;
+
+    return lval;
+}
+
 lval_t *lval_string(const char *string)
 {
     lval_t *lval = malloc(sizeof(lval_t));
@@ -44,12 +166,63 @@ lval_t *lval_string(const char *string)
         return NULL;
 
     lval->type = STRING;
-    lval->string = strdup(string);
+    lval->string = lstr_new(string, strlen(string));
+
+    return lval;
+}
+
+// Return a string lval with a copy of the first bytes of a text, which may include NUL bytes.
+lval_t *lval_string_n(const char *text, size_t length)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = STRING;
+    lval->string = lstr_new(text, length);
+
+    return lval;
+}
+
+// Return a lval with a rope. Takes ownership of the rope.
+lval_t *lval_rope(lrope_t *rope)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = ROPE;
+    lval->rope = rope;
+
+    return lval;
+}
+
+// Return a lval referring to a string builder. Takes ownership of the reference.
+lval_t *lval_builder(lbuilder_t *builder)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = BUILDER;
+    lval->builder = builder;
 
     return lval;
 }
 
 
+// Copy a symbol into an lval, inline when it is short enough.
+static void lval_set_symbol(lval_t *lval, const char *symbol)
+{
+    size_t length = strlen(symbol);
+
+    lval->symbol = length < LVAL_INLINE_SYMBOL ? lval->inline_symbol : malloc(sizeof(char) * length + 1);
+    memcpy(lval->symbol, symbol, length + 1);
+}
+
 // Return an lval with a given symbol.
 lval_t *lval_sym(const char *symbol)
 {
@@ -59,8 +232,7 @@ lval_t *lval_sym(const char *symbol)
         return NULL;
 
     lval->type = SYMBOL;
-    lval->symbol = malloc(sizeof(char) * strlen(symbol) + 1);
-    strcpy(lval->symbol, symbol);
+    lval_set_symbol(lval, symbol);
 
     return lval;
 }
@@ -76,6 +248,7 @@ lval_t *lval_sexpr()
     lval->type = SEXPR;
     lval->count = 0;
     lval->cell = NULL;
+    lval->shared = NULL;
 
     return lval;
 }
@@ -91,6 +264,7 @@ lval_t *lval_qexpr()
     lval->type = QEXPR;
     lval->count = 0;
     lval->cell = NULL;
+    lval->shared = NULL;
 
     return lval;
 }
@@ -105,6 +279,30 @@ lval_t *lval_fun(lbuiltin function)
 
     lval->type = FUN;
     lval->builtin = function;
+    lval->native = NULL;
+    lval->lambda = NULL;
+    lval->count = 0;
+    lval->cell = NULL;
+    lval->shared = NULL;
+
+    return lval;
+}
+
+// Return an lval with a builtin using the array calling convention.
+lval_t *lval_native(const lnative_t *native)
+{
+    lval_t *lval = malloc(sizeof(lval_t));
+
+    if (!lval)
+        return NULL;
+
+    lval->type = FUN;
+    lval->builtin = NULL;
+    lval->native = native;
+    lval->lambda = NULL;
+    lval->count = 0;
+    lval->cell = NULL;
+    lval->shared = NULL;
 
     return lval;
 }
@@ -118,13 +316,64 @@ lval_t *lval_lambda(lenv_t *env, lval_t *formals, lval_t *body)
 
     lval->type = FUN;
     lval->builtin = NULL;
-    lval->env = lenv_new(env->parser);
-    lval->formals = formals;
-    lval->body = body;
+    lval->native = NULL;
+    lval->lambda = llambda_new(formals, body);
+    lval->count = 0;
+    lval->cell = NULL;
+    lval->shared = NULL;
 
     return lval;
 }
 
+// Return the shared code of a new lambda.
+llambda_t *llambda_new(lval_t *formals, lval_t *body)
+{
+    llambda_t *lambda = malloc(sizeof(llambda_t));
+
+    if (!lambda)
+        return NULL;
+
+    lambda->refs = 1;
+    lambda->formals = formals;
+    lambda->body = body;
+    lambda->memo = NULL;
+    lambda->inlined = NULL;
+    lambda->deps = (ldeps_t){0};
+
+    return lambda;
+}
+
+// Values used everywhere, preallocated once: never freed nor copied, they are compared by identity.
+static lval_t lval_immortals[] = {
+    {.type = SEXPR},
+    {.type = QEXPR},
+    {.type = NUMBER, .number = 0},
+    {.type = NUMBER, .number = 1},
+};
+
+bool lval_is_immortal(const lval_t *lval)
+{
+    return (uintptr_t)lval - (uintptr_t)lval_immortals < sizeof(lval_immortals);
+}
+
+// Return the empty s-expression, the result of builtins called for their side effects.
+lval_t *lval_nil(void)
+{
+    return &lval_immortals[0];
+}
+
+// Return the empty q-expression.
+lval_t *lval_empty(void)
+{
+    return &lval_immortals[1];
+}
+
+// Return the number for a truth value, 1 or 0.
+lval_t *lval_bool(bool value)
+{
+    return &lval_immortals[value ? 3 : 2];
+}
+
 // Return an lval with an error code.
 lval_t *lval_err(const char *fmt, ...)
 {
@@ -168,14 +417,48 @@ lval_t *lenv_get(lenv_t *env, const char *sym)
     return lval_err("symbol '%s' not found", sym);
 }
 
+// Return the lval matching a symbol name without cloning it,
+// or NULL if the symbol could not be found.
+lval_t *lenv_peek(lenv_t *env, const char *sym)
+{
+    for (; env; env = env->parent) {
+        for (size_t i = 0; i < env->count; i++) {
+            if (strcmp(sym, env->syms[i]) == 0)
+                return env->vals[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Return the `lenv_generation` a global binding last changed at, 0 if the symbol is not bound.
+size_t lenv_stamp(lenv_t *env, const char *sym)
+{
+    for (size_t i = 0; i < env->count; i++) {
+        if (strcmp(sym, env->syms[i]) == 0)
+            return env->stamps[i];
+    }
+
+    return 0;
+}
+
 // Push a new lval to the local env, replace an existing value
 // if the key is already part of the environment.
 void lenv_push(lenv_t *env, lval_t *key, lval_t *value)
 {
+    bool global = !env->parent;
+
+    if (global)
+        lenv_generation++;
+
     for (size_t i = 0; i < env->count; ++i) {
         if (strcmp(key->symbol, env->syms[i]) == 0) {
             lval_del(env->vals[i]);
             env->vals[i] = lval_clone(value);
+
+            if (global)
+                env->stamps[i] = lenv_generation;
+
             return;
         }
     }
@@ -186,6 +469,11 @@ void lenv_push(lenv_t *env, lval_t *key, lval_t *value)
 
     env->syms[env->count - 1] = strdup(key->symbol);
     env->vals[env->count - 1] = lval_clone(value);
+
+    if (global) {
+        env->stamps = realloc(env->stamps, sizeof(size_t) * env->count);
+        env->stamps[env->count - 1] = lenv_generation;
+    }
 }
 
 // Push a new lval to the global env, replace an existing value
@@ -208,6 +496,122 @@ void lenv_add_builtin(lenv_t *env, const char *name, lbuiltin function)
     lval_del(fun);
 }
 
+// Type expected by a character of a builtin signature, -1 for any type.
+static int lnative_type(char c)
+{
+    switch (c) {
+        case 'l': return LNATIVE_LIST;
+        case 'n': return NUMBER;
+        case 's': return STRING;
+        case 'y': return SYMBOL;
+        case 'f': return FUN;
+        case 'q': return QEXPR;
+        case 'a': return ARRAY;
+        case 'v': return VECTOR;
+        case 'm': return MAP;
+        case 't': return TABLE;
+        case 'b': return BUILDER;
+        case 'x': return LNATIVE_TEXT;
+        default: return -1;
+    }
+}
+
+// Add a builtin using the array calling convention to an environment.
+// Its signature is parsed once here, instead of at every call.
+void lenv_add_native(lenv_t *env, lnative_t *native)
+{
+    const char *signature = native->signature;
+
+    native->arity = 0;
+    native->variadic = false;
+
+    for (; *signature && native->arity < LNATIVE_MAX_PARAMS; ++signature)
+    {
+        if (*signature == '*')
+            native->variadic = true;
+        else
+            native->types[native->arity++] = lnative_type(*signature);
+    }
+
+    lval_t *sym = lval_sym(native->name);
+    lval_t *fun = lval_native(native);
+
+    lenv_push(env, sym, fun);
+
+    lval_del(sym);
+    lval_del(fun);
+}
+
+// Builtins using the array calling convention.
+static lnative_t natives[] = {
+    {.name = "crouton", .function = &builtin_head, .signature = "q"},
+    {.name = "rest", .function = &builtin_tail, .signature = "q"},
+    {.name = "cook", .function = &builtin_eval, .signature = "q"},
+    {.name = "assemble", .function = &builtin_join, .signature = "q*"},
+    {.name = "memo-clear", .function = &builtin_memo_clear, .signature = "f"},
+    {.name = "memo-stats", .function = &builtin_memo_stats, .signature = "f"},
+    {.name = "pure?", .function = &builtin_pure, .signature = "f"},
+    {.name = "effect", .function = &builtin_effect, .signature = "f"},
+    {.name = "say", .function = &builtin_print, .signature = ".*"},
+    {.name = "you-suck-at-cooking", .function = &builtin_error, .signature = "s"},
+    {.name = "map", .function = &builtin_map, .signature = "fq"},
+    {.name = "filter", .function = &builtin_filter, .signature = "fq"},
+    {.name = "fold-left", .function = &builtin_fold_left, .signature = "f.."},
+    {.name = "fold-right", .function = &builtin_fold_right, .signature = "f.q"},
+    {.name = "for-each", .function = &builtin_for_each, .signature = "f."},
+    {.name = "pack", .function = &builtin_pack, .signature = "q"},
+    {.name = "unpack", .function = &builtin_unpack, .signature = "a"},
+    {.name = "length", .function = &builtin_length, .signature = "l"},
+    {.name = "nth", .function = &builtin_nth, .signature = "ln"},
+    {.name = "last", .function = &builtin_last, .signature = "l"},
+    {.name = "slice", .function = &builtin_slice, .signature = "lnn"},
+    {.name = "reverse", .function = &builtin_reverse, .signature = "l"},
+    {.name = "range", .function = &builtin_range, .signature = "n*"},
+    {.name = "iterate", .function = &builtin_iterate, .signature = "f."},
+    {.name = "take", .function = &builtin_take, .signature = "n."},
+    {.name = "drop", .function = &builtin_drop, .signature = "n."},
+    {.name = "lazy-map", .function = &builtin_lazy_map, .signature = "f."},
+    {.name = "lazy-filter", .function = &builtin_lazy_filter, .signature = "f."},
+    {.name = "force", .function = &builtin_force, .signature = "."},
+    {.name = "mapping", .function = &builtin_mapping, .signature = "f"},
+    {.name = "filtering", .function = &builtin_filtering, .signature = "f"},
+    {.name = "comp", .function = &builtin_comp, .signature = "q*"},
+    {.name = "transduce", .function = &builtin_transduce, .signature = "qf.."},
+    {.name = "vector", .function = &builtin_vector, .signature = ".*"},
+    {.name = "vec", .function = &builtin_vec, .signature = "l"},
+    {.name = "conj", .function = &builtin_conj, .signature = "v.*"},
+    {.name = "assoc", .function = &builtin_assoc, .signature = "..."},
+    {.name = "dict", .function = &builtin_dict, .signature = "q"},
+    {.name = "get", .function = &builtin_get, .signature = "m.*"},
+    {.name = "dissoc", .function = &builtin_dissoc, .signature = "m."},
+    {.name = "keys", .function = &builtin_keys, .signature = "m"},
+    {.name = "merge", .function = &builtin_merge, .signature = "m*"},
+    {.name = "hash", .function = &builtin_hash, .signature = "."},
+    {.name = "ht-new", .function = &builtin_ht_new, .signature = "n"},
+    {.name = "ht-put!", .function = &builtin_ht_put, .signature = "t.."},
+    {.name = "ht-get", .function = &builtin_ht_get, .signature = "t.*"},
+    {.name = "ht-update!", .function = &builtin_ht_update, .signature = "t.f."},
+    {.name = "ht-count", .function = &builtin_ht_count, .signature = "t"},
+    {.name = "ht-entries", .function = &builtin_ht_entries, .signature = "t"},
+    {.name = "concat", .function = &builtin_concat, .signature = "x*"},
+    {.name = "substr", .function = &builtin_substr, .signature = "xnn"},
+    {.name = "str-len", .function = &builtin_str_len, .signature = "x"},
+    {.name = "str-split", .function = &builtin_str_split, .signature = "xx"},
+    {.name = "sb-new", .function = &builtin_sb_new, .signature = "n"},
+    {.name = "sb-append!", .function = &builtin_sb_append, .signature = "bx*"},
+    {.name = "sb-build", .function = &builtin_sb_build, .signature = "b"},
+    {.name = "sum", .function = &builtin_sum, .signature = "a"},
+    {.name = "smallest", .function = &builtin_smallest, .signature = "a"},
+    {.name = "biggest", .function = &builtin_biggest, .signature = "a"},
+    {.name = "dot", .function = &builtin_dot, .signature = "aa"},
+    {.name = "add-each", .function = &builtin_array_add, .signature = "a."},
+    {.name = "strain-each", .function = &builtin_array_sub, .signature = "a."},
+    {.name = "mix-each", .function = &builtin_array_mul, .signature = "a."},
+    {.name = "same-each", .function = &builtin_array_eq, .signature = "a."},
+    {.name = "smaller-each", .function = &builtin_array_lt, .signature = "a."},
+    {.name = "bigger-each", .function = &builtin_array_gt, .signature = "a."},
+};
+
 // Add all builtins function pointer to an environment.
 void lenv_add_builtins(lenv_t *env)
 {
@@ -222,19 +626,29 @@ void lenv_add_builtins(lenv_t *env)
     lenv_add_builtin(env, "smaller-or-same", &builtin_op_lesser_equal);
     lenv_add_builtin(env, "same", &builtin_cmp_eq);
     lenv_add_builtin(env, "not", &builtin_cmp_neq);
-    lenv_add_builtin(env, "crouton", &builtin_head);
-    lenv_add_builtin(env, "rest", &builtin_tail);
     lenv_add_builtin(env, "list", &builtin_list);
-    lenv_add_builtin(env, "cook", &builtin_eval);
-    lenv_add_builtin(env, "assemble", &builtin_join);
     lenv_add_builtin(env, "shelf", &builtin_def);
     lenv_add_builtin(env, "table", &builtin_push);
     lenv_add_builtin(env, "improv", &builtin_lambda);
     lenv_add_builtin(env, "recipe", &builtin_fn);
+    lenv_add_builtin(env, "memo-recipe", &builtin_memo_fn);
     lenv_add_builtin(env, "if", &builtin_if);
+    lenv_add_builtin(env, "loop", &builtin_loop);
+    lenv_add_builtin(env, "recur", &builtin_recur);
     lenv_add_builtin(env, "recall", &builtin_load);
-    lenv_add_builtin(env, "say", &builtin_print);
-    lenv_add_builtin(env, "you-suck-at-cooking", &builtin_error);
+
+    for (size_t i = 0; i < sizeof(natives) / sizeof(natives[0]); ++i)
+        lenv_add_native(env, &natives[i]);
+
+    const char *constants[] = {"nil", "nothing", "yeah", "na"};
+    lval_t *values[] = {lval_nil(), lval_empty(), lval_bool(true), lval_bool(false)};
+
+    for (size_t i = 0; i < sizeof(constants) / sizeof(constants[0]); ++i)
+    {
+        lval_t *sym = lval_sym(constants[i]);
+        lenv_push(env, sym, values[i]);
+        lval_del(sym);
+    }
 }
 
 
@@ -262,16 +676,44 @@ lval_t *lval_read_num(const mpc_ast_t *ast)
     errno = 0;
     long number = strtol(ast->contents, NULL, 10);
 
-    return errno == ERANGE ? lval_err("Expression '%s' is not a number", ast->contents) : lval_num(number);
+    return errno == ERANGE ? lval_big(lbig_read(ast->contents)) : lval_num(number);
 }
 
+lval_t *lval_read_float(const mpc_ast_t *ast)
+{
+    return lval_float(strtod(ast->contents, NULL));
+}
+
+// Characters escaped in string literals, and the letters of their escape sequences.
+static const char lval_escapes[] = {'\a', '\b', '\f', '\n', '\r', '\t', '\v', '\\', '\'', '\"', '\0'};
+static const char lval_escape_letters[] = {'a', 'b', 'f', 'n', 'r', 't', 'v', '\\', '\'', '"', '0'};
+
 lval_t *lval_read_string(const mpc_ast_t *ast)
 {
-    char *unescaped = strndup(ast->contents + 1, strlen(ast->contents) - 2);
+    // Without the quotes.
+    const char *escaped = ast->contents + 1;
+    size_t count = strlen(escaped) - 1;
+    char *unescaped = malloc(count + 1);
+    size_t length = 0;
 
-    unescaped = mpcf_unescape(unescaped);
+    for (size_t i = 0; i < count; ++i)
+    {
+        char c = escaped[i];
+
+        if (c == '\\' && i + 1 < count)
+        {
+            const char *letter = memchr(lval_escape_letters, escaped[i + 1], sizeof(lval_escape_letters));
+
+            if (letter) {
+                c = lval_escapes[letter - lval_escape_letters];
+                ++i;
+            }
+        }
+
+        unescaped[length++] = c;
+    }
 
-    lval_t *string = lval_string(unescaped);
+    lval_t *string = lval_string_n(unescaped, length);
 
     free(unescaped);
 
@@ -279,6 +721,65 @@ lval_t *lval_read_string(const mpc_ast_t *ast)
 }
 
 // Read a S or Q expression.
+// Q-expression literals read so far, each one mapped to itself.
+static ltable_t *lval_literals = NULL;
+
+// Check if a value can be interned: atoms and q-expressions of atoms,
+// which cannot be told apart from the values they are equal to.
+static bool lval_is_constant(const lval_t *lval)
+{
+    switch (lval->type) {
+        case NUMBER:
+        case BIGNUM:
+        case FLOAT:
+        case STRING:
+        case SYMBOL:
+            return true;
+        case QEXPR:
+            for (size_t i = 0; i < lval->count; ++i) {
+                if (!lval_is_constant(lval->cell[i]))
+                    return false;
+            }
+
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief Share a q-expression literal with the equal ones read before it (hash-consing).
+/// @param literal q-expression read from the source.
+/// @return a view of the first literal equal to it.
+static lval_t *lval_intern(lval_t *literal)
+{
+    if (!lval_intern_literals || !lval_is_constant(literal))
+        return literal;
+
+    if (!lval_literals)
+        lval_literals = ltable_new(0);
+
+    lval_t *interned = ltable_get(lval_literals, literal);
+
+    if (interned) {
+        lval_del(literal);
+        return interned;
+    }
+
+    ltable_put(lval_literals, lval_clone(literal), lval_clone(literal));
+    literal->shared->interned = true;
+
+    return literal;
+}
+
+// Release the interned literals, those still in use are freed with their last view.
+void lval_literals_del(void)
+{
+    if (lval_literals)
+        ltable_unref(lval_literals);
+
+    lval_literals = NULL;
+}
+
 lval_t *lval_read_expr(const mpc_ast_t *ast, lval_type_t expr_type)
 {
     if (expr_type != SEXPR && expr_type != QEXPR)
@@ -298,12 +799,20 @@ lval_t *lval_read_expr(const mpc_ast_t *ast, lval_type_t expr_type)
         expr = lval_add(expr, lval_read(ast->children[i]));
     }
 
-    return expr;
+    if (!expr->count)
+    {
+        lval_del(expr);
+        return expr_type == SEXPR ? lval_nil() : lval_empty();
+    }
+
+    return expr_type == QEXPR ? lval_intern(expr) : expr;
 }
 
 lval_t *lval_read(const mpc_ast_t *ast)
 {
-    if (strstr(ast->tag, "number"))
+    if (strstr(ast->tag, "float"))
+        return lval_read_float(ast);
+    else if (strstr(ast->tag, "number"))
         return lval_read_num(ast);
     else if (strstr(ast->tag, "string"))
         return lval_read_string(ast);
@@ -317,11 +826,48 @@ lval_t *lval_read(const mpc_ast_t *ast)
         return NULL;
 }
 
+/// @brief Make room for `count` children in an expression, keeping the first ones.
+/// Small expressions keep their children inline, larger ones spill them to the heap.
+static void lval_resize_cells(lval_t *lval, size_t count)
+{
+    size_t kept = lval->count < count ? lval->count : count;
+
+    if (count <= LVAL_INLINE_CELLS)
+    {
+        if (lval->cell != lval->inline_cell)
+        {
+            if (kept)
+                memcpy(lval->inline_cell, lval->cell, sizeof(lval_t *) * kept);
+
+            free(lval->cell);
+            lval->cell = lval->inline_cell;
+        }
+
+        return;
+    }
+
+    if (lval->cell == lval->inline_cell)
+    {
+        lval->cell = malloc(sizeof(lval_t *) * count);
+        memcpy(lval->cell, lval->inline_cell, sizeof(lval_t *) * kept);
+    }
+    else
+        lval->cell = realloc(lval->cell, sizeof(lval_t *) * count);
+}
+
+// Free the storage of the children of an expression, once they are deleted or moved.
+static void lval_free_cells(lval_t *lval)
+{
+    if (lval->cell != lval->inline_cell)
+        free(lval->cell);
+}
+
 lval_t *lval_add(lval_t *dest, lval_t *other)
 {
-    dest->count++;
-    dest->cell = realloc(dest->cell, sizeof(lval_t *) * dest->count);
-    dest->cell[dest->count - 1] = other;
+    lval_unshare(dest);
+
+    lval_resize_cells(dest, dest->count + 1);
+    dest->cell[dest->count++] = other;
 
     return dest;
 }
@@ -333,14 +879,16 @@ lval_t *lval_add(lval_t *dest, lval_t *other)
 /// @return the popped lval.
 lval_t *lval_pop(lval_t *lval, unsigned int index)
 {
+    lval_unshare(lval);
+
     if (index <= lval->count - 1)
     {
         lval_t *pop = lval->cell[index];
 
         // Move pointers to the start of the given index to remove the desired element.
         memmove(&lval->cell[index], &lval->cell[index + 1], sizeof(lval_t *) * (lval->count - index - 1));
+        lval_resize_cells(lval, lval->count - 1);
         lval->count--;
-        lval->cell = realloc(lval->cell, sizeof(lval_t *) * lval->count);
 
         return pop;
     }
@@ -352,507 +900,3197 @@ lval_t *lval_pop(lval_t *lval, unsigned int index)
 
 lval_t *lval_take(lval_t *lval, unsigned int index)
 {
+    // Shared cells are left to the other views.
+    if (lval->shared && index < lval->count)
+    {
+        lval_t *pop = lval_clone(lval->cell[index]);
+        lval_del(lval);
+        return pop;
+    }
+
     lval_t *pop = lval_pop(lval, index);
     lval_del(lval);
     return pop;
 }
 
+//  --------------
+// | shared cells |
+//  --------------
+
+static void lcells_unref(lcells_t *cells)
+{
+    if (--cells->refs)
+        return;
+
+    for (size_t i = 0; i < cells->count; ++i)
+        lval_del(cells->cell[i]);
+
+    free(cells->cell);
+    free(cells);
+}
+
+// Move the cells of a q-expression to shared storage, so views can be taken over them.
+static void lval_share(lval_t *lval)
+{
+    if (lval->shared)
+        return;
+
+    // Shared cells outlive the q-expression they come from.
+    if (lval->cell == lval->inline_cell)
+    {
+        lval->cell = malloc(sizeof(lval_t *) * lval->count);
+        memcpy(lval->cell, lval->inline_cell, sizeof(lval_t *) * lval->count);
+    }
+
+    lval->shared = malloc(sizeof(lcells_t));
+    lval->shared->refs = 1;
+    lval->shared->count = lval->count;
+    lval->shared->cell = lval->cell;
+    lval->shared->hash = 0;
+    lval->shared->interned = false;
+}
+
+// Give an expression cells of its own before modifying them. The cells of the only
+// view left are reused in place, otherwise the elements of the view are cloned.
+void lval_unshare(lval_t *lval)
+{
+    lcells_t *shared = lval->shared;
+
+    if (!shared)
+        return;
+
+    lval->shared = NULL;
+
+    if (shared->refs == 1)
+    {
+        size_t start = lval->cell - shared->cell;
+
+        for (size_t i = 0; i < shared->count; ++i) {
+            if (i < start || i >= start + lval->count)
+                lval_del(shared->cell[i]);
+        }
+
+        if (lval->count)
+            memmove(shared->cell, lval->cell, sizeof(lval_t *) * lval->count);
+
+        lval->cell = shared->cell;
+        free(shared);
+        return;
+    }
+
+    lval_t **cell = lval->count > LVAL_INLINE_CELLS ? malloc(sizeof(lval_t *) * lval->count) : lval->inline_cell;
+
+    for (size_t i = 0; i < lval->count; ++i)
+        cell[i] = lval_clone(lval->cell[i]);
+
+    shared->refs--;
+    lval->cell = cell;
+}
+
+// Return a q-expression viewing `count` elements of another one from index `start`, in O(1).
+static lval_t *lval_view(lval_t *lval, size_t start, size_t count)
+{
+    lval_t *view = lval_qexpr();
+
+    if (!count)
+        return view;
+
+    lval_share(lval);
+    lval->shared->refs++;
+
+    view->shared = lval->shared;
+    view->cell = &lval->cell[start];
+    view->count = count;
+
+    return view;
+}
+
+//  ----------------------
+// | evaluate expressions |
 //  ----------------------
-// | evaluate expressions |
-//  ----------------------
 
-lval_t *lval_eval(lenv_t *env, lval_t *lval)
+// Turn a q-expression into the s-expression evaluating it.
+// The empty q-expression is immortal, it becomes the empty s-expression.
+static lval_t *lval_to_sexpr(lval_t *q)
+{
+    if (q == lval_empty())
+        return lval_nil();
+
+    q->type = SEXPR;
+    return q;
+}
+
+lval_t *lval_eval(lenv_t *env, lval_t *lval)
+{
+    if (lval->type == SYMBOL) {
+        lval_t *val = lenv_get(env, lval->symbol);
+        lval_del(lval);
+        return val;
+    }
+
+    if (lval->type == SEXPR)
+        return lval_eval_sexpr(env, lval);
+
+    return lval;
+}
+
+// Numerical operators implemented by `builtin_op`, NULL for other builtins.
+static const char *lval_unboxed_op(lbuiltin builtin)
+{
+    if (builtin == &builtin_op_add) return "+";
+    if (builtin == &builtin_op_sub) return "-";
+    if (builtin == &builtin_op_mul) return "*";
+    if (builtin == &builtin_op_div) return "/";
+    if (builtin == &builtin_op_mod) return "%";
+    if (builtin == &builtin_op_greater) return ">";
+    if (builtin == &builtin_op_greater_equal) return ">=";
+    if (builtin == &builtin_op_lesser) return "<";
+    if (builtin == &builtin_op_lesser_equal) return "<=";
+
+    return NULL;
+}
+
+// Return the builtin called by a s-expr without evaluating it, NULL if it is not a builtin call.
+static lbuiltin lval_peek_builtin(lenv_t *env, const lval_t *lval)
+{
+    if (lval->count < 2 || lval->cell[0]->type != SYMBOL)
+        return NULL;
+
+    lval_t *fun = lenv_peek(env, lval->cell[0]->symbol);
+
+    return fun && fun->type == FUN ? fun->builtin : NULL;
+}
+
+// Check if a s-expr calls a builtin that can compute on unboxed numbers.
+static bool lval_unboxable(lbuiltin builtin, const lval_t *lval)
+{
+    // Wide sums and products go through `builtin_op`, which vectorizes them over floats.
+    if ((builtin == &builtin_op_add || builtin == &builtin_op_mul) && lval->count - 1 >= LVAL_VECTOR_MIN)
+        return false;
+
+    if (builtin == &builtin_cmp_eq || builtin == &builtin_cmp_neq)
+        return lval->count == 3;
+
+    return builtin && lval_unboxed_op(builtin);
+}
+
+// Move the children of a s-expr to `cells` and free it.
+static void lval_steal_cells(lval_t *lval, lval_t **cells)
+{
+    memcpy(cells, lval->cell, sizeof(lval_t *) * lval->count);
+    lval->count = 0;
+    lval_del(lval);
+}
+
+static void lval_del_cells(lval_t **cells, size_t from, size_t count)
+{
+    for (size_t i = from; i < count; ++i)
+        lval_del(cells[i]);
+}
+
+// Free an owned s-expr whose operands before `from` have already been consumed.
+static void lval_release(lval_t *lval, bool owned, size_t from)
+{
+    if (!owned)
+        return;
+
+    lval_del(lval->cell[0]);
+
+    for (size_t i = from; i < lval->count; ++i)
+        lval_del(lval->cell[i]);
+
+    lval->count = 0;
+    lval_del(lval);
+}
+
+// Value of a numerical operator being applied: a fixnum, promoted to
+// a bignum while it does not fit a `long`, or a float once a float operand is seen.
+typedef struct
+{
+    long fixnum;
+    lbig_t *big;
+
+    bool floating;
+    double real;
+} lacc_t;
+
+// Check if a numerical operator is a comparison, whose result is always a number.
+static bool lval_op_is_cmp(const char *symbol)
+{
+    return symbol[0] == '<' || symbol[0] == '>';
+}
+
+// Check if a builtin compares its operands, giving a truth value.
+static bool lval_builtin_is_cmp(lbuiltin builtin)
+{
+    const char *op = lval_unboxed_op(builtin);
+
+    return builtin == &builtin_cmp_eq || builtin == &builtin_cmp_neq || (op && lval_op_is_cmp(op));
+}
+
+/// @brief Apply a numerical operator to floats.
+/// @return false on a division by zero.
+static bool lval_float_apply(const char *symbol, double *result, double next)
+{
+    if (strcmp(symbol, "-") == 0)
+        *result -= next;
+    else if (strcmp(symbol, "+") == 0)
+        *result += next;
+    else if (strcmp(symbol, "*") == 0)
+        *result *= next;
+    else if (strcmp(symbol, "/") == 0 || strcmp(symbol, "%") == 0)
+    {
+        if (next == 0)
+            return false;
+
+        *result = symbol[0] == '/' ? *result / next : fmod(*result, next);
+    }
+    else if (strcmp(symbol, ">") == 0)
+        *result = *result > next;
+    else if (strcmp(symbol, ">=") == 0)
+        *result = *result >= next;
+    else if (strcmp(symbol, "<") == 0)
+        *result = *result < next;
+    else if (strcmp(symbol, "<=") == 0)
+        *result = *result <= next;
+
+    return true;
+}
+
+/// @brief Apply a numerical operator to two bignums.
+/// @return the result, or NULL on a division by zero.
+static lbig_t *lbig_op_apply(const char *symbol, const lbig_t *a, const lbig_t *b)
+{
+    if (strcmp(symbol, "-") == 0)
+        return lbig_sub(a, b);
+    if (strcmp(symbol, "+") == 0)
+        return lbig_add(a, b);
+    if (strcmp(symbol, "*") == 0)
+        return lbig_mul(a, b);
+
+    if (strcmp(symbol, "/") == 0 || strcmp(symbol, "%") == 0)
+    {
+        if (lbig_is_zero(b))
+            return NULL;
+
+        if (symbol[0] == '/')
+            return lbig_divmod(a, b, NULL);
+
+        lbig_t *rem;
+        lbig_del(lbig_divmod(a, b, &rem));
+        return rem;
+    }
+
+    int cmp = lbig_cmp(a, b);
+
+    if (strcmp(symbol, ">") == 0)
+        return lbig_from_long(cmp > 0);
+    if (strcmp(symbol, ">=") == 0)
+        return lbig_from_long(cmp >= 0);
+    if (strcmp(symbol, "<") == 0)
+        return lbig_from_long(cmp < 0);
+
+    return lbig_from_long(cmp <= 0);
+}
+
+// Go back to a fixnum once the accumulated bignum fits a `long`.
+static void lacc_demote(lacc_t *acc)
+{
+    if (acc->big && lbig_to_long(acc->big, &acc->fixnum)) {
+        lbig_del(acc->big);
+        acc->big = NULL;
+    }
+}
+
+// Start accumulating from the first operand of a numerical operator.
+static void lacc_init(lacc_t *acc, long fixnum, const lval_t *boxed)
+{
+    acc->fixnum = fixnum;
+    acc->big = boxed && boxed->type == BIGNUM ? lbig_clone(boxed->big) : NULL;
+    acc->floating = boxed && boxed->type == FLOAT;
+    acc->real = acc->floating ? boxed->real : 0;
+}
+
+// Switch the accumulated value to a float.
+static void lacc_float(lacc_t *acc)
+{
+    if (acc->floating)
+        return;
+
+    acc->floating = true;
+    acc->real = acc->big ? lbig_to_double(acc->big) : (double)acc->fixnum;
+
+    if (acc->big) {
+        lbig_del(acc->big);
+        acc->big = NULL;
+    }
+}
+
+/// @brief Apply a numerical operator to an accumulated value. Fixnums are
+///        used as long as the result fits, bignums only when it does not,
+///        and floats as soon as one of the operands is a float.
+/// @param boxed operand if it is a bignum or a float, NULL to use `fixnum`.
+/// @return false on a division by zero.
+static bool lacc_apply(lacc_t *acc, const char *symbol, long fixnum, const lval_t *boxed)
+{
+    if (!acc->big && !acc->floating && !boxed && lval_op_apply(symbol, &acc->fixnum, fixnum))
+        return true;
+
+    if (acc->floating || (boxed && boxed->type == FLOAT))
+    {
+        lacc_float(acc);
+
+        if (!boxed)
+            return lval_float_apply(symbol, &acc->real, fixnum);
+
+        return lval_float_apply(symbol, &acc->real, boxed->type == FLOAT ? boxed->real : lbig_to_double(boxed->big));
+    }
+
+    lbig_t *promoted_acc = acc->big ? NULL : lbig_from_long(acc->fixnum);
+    lbig_t *promoted = boxed ? NULL : lbig_from_long(fixnum);
+    lbig_t *result = lbig_op_apply(symbol, acc->big ? acc->big : promoted_acc, boxed ? boxed->big : promoted);
+
+    if (promoted_acc)
+        lbig_del(promoted_acc);
+    if (promoted)
+        lbig_del(promoted);
+
+    if (!result)
+        return false;
+
+    if (acc->big)
+        lbig_del(acc->big);
+
+    acc->big = result;
+    lacc_demote(acc);
+
+    return true;
+}
+
+static void lacc_negate(lacc_t *acc)
+{
+    if (acc->floating) {
+        acc->real = -acc->real;
+        return;
+    }
+
+    if (!acc->big && acc->fixnum != LONG_MIN) {
+        acc->fixnum = -acc->fixnum;
+        return;
+    }
+
+    lbig_t *big = acc->big ? acc->big : lbig_from_long(acc->fixnum);
+
+    acc->big = lbig_neg(big);
+    lbig_del(big);
+    lacc_demote(acc);
+}
+
+// Box the accumulated value of an operator. Comparisons, even between floats, give truth values.
+static lval_t *lacc_box(lacc_t *acc, const char *symbol)
+{
+    if (lval_op_is_cmp(symbol) && !acc->big)
+        return lval_bool(acc->floating ? acc->real != 0 : acc->fixnum != 0);
+
+    if (acc->floating)
+        return lval_float(acc->real);
+
+    return acc->big ? lval_big(acc->big) : lval_num(acc->fixnum);
+}
+
+static lval_t *lval_eval_unboxed(lenv_t *, lval_t *, bool, long *);
+
+/// @brief Evaluate a numerical operator without building its list of arguments.
+///        Operands are computed in place, nested operations never allocate
+///        unless they overflow to bignums or compute on floats.
+/// @param owned true to consume the expression, false to leave it untouched.
+/// @return NULL with the result in `out`, the result if it is a bignum or a float, or an error.
+static lval_t *lval_eval_op(lenv_t *env, lval_t *lval, bool owned, const char *op, long *out)
+{
+    size_t count = lval->count;
+    bool not_number = false;
+    bool zero_division = false;
+    lacc_t acc = {.fixnum = 0, .big = NULL, .floating = false};
+
+    // Like `builtin_op`, all operands are evaluated before reporting errors.
+    for (size_t i = 1; i < count; ++i)
+    {
+        long value = 0;
+        lval_t *boxed = lval_eval_unboxed(env, lval->cell[i], owned, &value);
+
+        if (boxed && boxed->type == ERROR)
+        {
+            if (acc.big)
+                lbig_del(acc.big);
+
+            lval_release(lval, owned, i + 1);
+            return boxed;
+        }
+
+        if (boxed && boxed->type != BIGNUM && boxed->type != FLOAT)
+            not_number = true;
+        else if (i == 1)
+            lacc_init(&acc, value, boxed);
+        else if (!not_number && !zero_division)
+            zero_division = !lacc_apply(&acc, op, value, boxed);
+
+        if (boxed)
+            lval_del(boxed);
+    }
+
+    lval_release(lval, owned, count);
+
+    if (not_number || zero_division)
+    {
+        if (acc.big)
+            lbig_del(acc.big);
+
+        return lval_err(not_number ? "Numerical operators can only be applied to numbers" : "Cannot divide by zero");
+    }
+
+    if (count == 2 && strcmp(op, "-") == 0)
+        lacc_negate(&acc);
+
+    if (acc.big || (acc.floating && !lval_op_is_cmp(op)))
+        return lacc_box(&acc, op);
+
+    *out = acc.floating ? (long)acc.real : acc.fixnum;
+    return NULL;
+}
+
+/// @brief Evaluate `same` or `not` without building its list of arguments.
+/// @param owned true to consume the expression, false to leave it untouched.
+/// @return NULL with the result in `out`, or an error.
+static lval_t *lval_eval_cmp(lenv_t *env, lval_t *lval, bool owned, bool equal, long *out)
+{
+    lval_t *boxed[2] = {NULL, NULL};
+    long numbers[2];
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        boxed[i] = lval_eval_unboxed(env, lval->cell[i + 1], owned, &numbers[i]);
+
+        if (boxed[i] && boxed[i]->type == ERROR)
+        {
+            if (i == 1 && boxed[0])
+                lval_del(boxed[0]);
+
+            lval_release(lval, owned, i + 2);
+            return boxed[i];
+        }
+    }
+
+    lval_release(lval, owned, 3);
+
+    // Numbers are never boxed here, a number and a boxed value have different types.
+    if (!boxed[0] && !boxed[1])
+        *out = numbers[0] == numbers[1];
+    else if (boxed[0] && boxed[1])
+        *out = lval_eq(boxed[0], boxed[1]);
+    else
+        *out = 0;
+
+    if (!equal)
+        *out = !*out;
+
+    for (size_t i = 0; i < 2; ++i) {
+        if (boxed[i])
+            lval_del(boxed[i]);
+    }
+
+    return NULL;
+}
+
+/// @brief Evaluate an expression whose value is only used as a number.
+///        The number does not escape, so it is returned in a local instead of a new lval.
+/// @param owned true to consume the expression, false to leave it untouched.
+/// @return NULL with the number in `out`, or the value of the expression if it is not a number.
+static lval_t *lval_eval_unboxed(lenv_t *env, lval_t *lval, bool owned, long *out)
+{
+    if (lval->type == NUMBER)
+    {
+        *out = lval->number;
+
+        if (owned)
+            lval_del(lval);
+
+        return NULL;
+    }
+
+    if (lval->type == SYMBOL)
+    {
+        lval_t *value = lenv_peek(env, lval->symbol);
+
+        if (value && value->type == NUMBER)
+        {
+            *out = value->number;
+
+            if (owned)
+                lval_del(lval);
+
+            return NULL;
+        }
+    }
+
+    if (lval->type == SEXPR)
+    {
+        lbuiltin builtin = lval_peek_builtin(env, lval);
+
+        if (lval_unboxable(builtin, lval))
+        {
+            if (builtin == &builtin_cmp_eq || builtin == &builtin_cmp_neq)
+                return lval_eval_cmp(env, lval, owned, builtin == &builtin_cmp_eq, out);
+
+            return lval_eval_op(env, lval, owned, lval_unboxed_op(builtin), out);
+        }
+    }
+
+    lval_t *value = lval_eval(env, owned ? lval : lval_clone(lval));
+
+    if (value->type != NUMBER)
+        return value;
+
+    *out = value->number;
+    lval_del(value);
+
+    return NULL;
+}
+
+// Evaluate `if` without boxing its condition nor building its list of arguments.
+static lval_t *lval_eval_if(lenv_t *env, lval_t *lval)
+{
+    size_t count = lval->count;
+    lval_t *cells[4];
+    lval_t *branches[2] = {NULL, NULL};
+    long cond;
+
+    lval_steal_cells(lval, cells);
+    lval_del(cells[0]);
+
+    lval_t *boxed = lval_eval_unboxed(env, cells[1], true, &cond);
+
+    if (boxed && boxed->type == ERROR)
+    {
+        lval_del_cells(cells, 2, count);
+        return boxed;
+    }
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        branches[i] = lval_eval(env, cells[i + 2]);
+
+        if (branches[i]->type == ERROR)
+        {
+            if (boxed)
+                lval_del(boxed);
+            if (i == 1)
+                lval_del(branches[0]);
+
+            lval_del_cells(cells, i + 3, count);
+            return branches[i];
+        }
+    }
+
+    // Let the builtin report invalid arguments.
+    if (boxed || branches[0]->type != QEXPR || branches[1]->type != QEXPR)
+    {
+        lval_t *args = lval_add(lval_sexpr(), boxed ? boxed : lval_num(cond));
+        return builtin_if(env, lval_add(lval_add(args, branches[0]), branches[1]));
+    }
+
+    lval_t *expr = branches[cond ? 0 : 1];
+    lval_del(branches[cond ? 1 : 0]);
+
+    return lval_eval(env, lval_to_sexpr(expr));
+}
+
+/// @brief Check the arguments of a builtin against its signature.
+/// @return NULL if they match, an error otherwise.
+static lval_t *lnative_check(const lnative_t *native, lval_t **argv, size_t argc)
+{
+    if (native->variadic ? argc < native->arity : argc != native->arity)
+        return lval_err("function '%s' expected %s%ld parameters, got %ld",
+                        native->name, native->variadic ? "at least " : "", native->arity, argc);
+
+    for (size_t i = 0; i < argc; ++i)
+    {
+        int expected = native->types[i < native->arity ? i : native->arity - 1];
+
+        bool matches = expected == LNATIVE_LIST
+            ? argv[i]->type == QEXPR || argv[i]->type == ARRAY || argv[i]->type == VECTOR
+            : expected == LNATIVE_TEXT
+            ? argv[i]->type == STRING || argv[i]->type == ROPE
+            : expected < 0 || argv[i]->type == expected;
+
+        if (!matches)
+            return lval_err("function '%s' expected children at index %ld to be of type '%s', not '%s'",
+                            native->name, i,
+                            expected == LNATIVE_LIST ? "List" : expected == LNATIVE_TEXT ? "Text" : lval_type_name(expected),
+                            lval_type_name(argv[i]->type));
+    }
+
+    return NULL;
+}
+
+// Call a builtin using the array calling convention with borrowed arguments.
+static lval_t *lval_call_native(lenv_t *env, const lnative_t *native, lval_t **argv, size_t argc)
+{
+    lval_t *err = lnative_check(native, argv, argc);
+
+    return err ? err : native->function(env, argv, argc);
+}
+
+// Free an expression whose children may have been taken by a builtin.
+static void lval_del_args(lval_t *lval)
+{
+    for (size_t i = 0; i < lval->count; ++i) {
+        if (lval->cell[i])
+            lval_del(lval->cell[i]);
+    }
+
+    lval->count = 0;
+    lval_del(lval);
+}
+
+// Evaluate a s-expr. The first element of an s-expr must be a function.
+lval_t *lval_eval_sexpr(lenv_t *env, lval_t *lval)
+{
+    // Children are evaluated in place.
+    lval_unshare(lval);
+
+    lbuiltin builtin = lval_peek_builtin(env, lval);
+
+    if (builtin == &builtin_if && lval->count == 4)
+        return lval_eval_if(env, lval);
+
+    if (lval_unboxable(builtin, lval))
+    {
+        long number;
+        lval_t *boxed = lval_eval_unboxed(env, lval, true, &number);
+
+        // The result escapes to the caller, it has to be boxed.
+        if (boxed)
+            return boxed;
+
+        return lval_builtin_is_cmp(builtin) ? lval_bool(number) : lval_num(number);
+    }
+
+    for (unsigned int i = 0; i < lval->count; ++i)
+    {
+        lval->cell[i] = lval_eval(env, lval->cell[i]);
+
+        if (lval->cell[i]->type == ERROR)
+            return lval_take(lval, i);
+    }
+
+    if (lval->count == 0)
+    {
+        return lval;
+    }
+
+    if (lval->count == 1)
+    {
+        return lval_take(lval, 0);
+    }
+
+    // Builtins using the array calling convention borrow the evaluated
+    // arguments in place, the s-expr is never reshaped.
+    if (lval->cell[0]->type == FUN && lval->cell[0]->native)
+    {
+        lval_t *result = lval_call_native(env, lval->cell[0]->native, &lval->cell[1], lval->count - 1);
+
+        lval_del_args(lval);
+        return result;
+    }
+
+    lval_t *first = lval_pop(lval, 0);
+
+    if (first->type != FUN)
+    {
+        lval_del(first);
+        lval_del(lval);
+        return lval_err("The first element of a S-Expression must be a function");
+    }
+
+    return lval_call(env, first, lval);
+}
+
+// Move the arguments of a call to a new frame, binding them to the formals of the lambda.
+static lenv_t *lenv_frame(lenv_t *env, const lval_t *formals, lval_t *args)
+{
+    lenv_t *frame = lenv_new(env->parser);
+
+    frame->parent = env;
+    frame->count = args->count;
+    frame->syms = malloc(sizeof(char *) * frame->count);
+    frame->vals = malloc(sizeof(lval_t *) * frame->count);
+
+    for (size_t i = 0; i < frame->count; ++i)
+    {
+        frame->syms[i] = strdup(formals->cell[i]->symbol);
+        frame->vals[i] = args->cell[i];
+    }
+
+    args->count = 0;
+    lval_del(args);
+
+    return frame;
+}
+
+// Whether a value is or holds a hash table or a string builder,
+// which can change without being redefined.
+static bool lval_is_mutable(const lval_t *lval)
+{
+    if (lval->type == TABLE || lval->type == BUILDER)
+        return true;
+
+    if (lval->type != SEXPR && lval->type != QEXPR && lval->type != FUN)
+        return false;
+
+    for (size_t i = 0; i < lval->count; ++i) {
+        if (lval_is_mutable(lval->cell[i]))
+            return true;
+    }
+
+    return false;
+}
+
+// Call a function with evaluated arguments.
+// Lambdas called with missing arguments are partially applied: the given
+// arguments are kept in the returned lambda until the remaining ones come.
+lval_t *lval_call(lenv_t *env, lval_t *func, lval_t *args)
+{
+    if (func->builtin)
+    {
+        lval_t *result = func->builtin(env, args);
+        lval_del(func);
+        return result;
+    }
+
+    if (func->native)
+    {
+        lval_t *result = lval_call_native(env, func->native, args->cell, args->count);
+        lval_del_args(args);
+        lval_del(func);
+        return result;
+    }
+
+    llambda_t *lambda = func->lambda;
+    size_t given = func->count + args->count;
+
+    if (given > lambda->formals->count)
+    {
+        lval_t *err = lval_err("lambda expected %ld parameter, got %ld", lambda->formals->count, given);
+        lval_del(func);
+        lval_del(args);
+        return err;
+    }
+
+    if (given < lambda->formals->count)
+    {
+        for (size_t i = 0; i < args->count; ++i)
+            lval_add(func, args->cell[i]);
+
+        args->count = 0;
+        lval_del(args);
+
+        return func;
+    }
+
+    // Arguments of a partial application come first.
+    if (func->count)
+    {
+        lval_resize_cells(args, given);
+        memmove(&args->cell[func->count], args->cell, sizeof(lval_t *) * args->count);
+        memcpy(args->cell, func->cell, sizeof(lval_t *) * func->count);
+        args->count = given;
+
+        lval_free_cells(func);
+        func->cell = NULL;
+        func->count = 0;
+    }
+
+    // Memoized recipes answer from their cache when called with known arguments.
+    // A table or a builder may have changed since a call made with it, it is never part of a key.
+    lval_t *key = NULL;
+
+    if (lambda->memo && !lval_is_mutable(args) && lmemo_sync(lambda->memo, env, func))
+    {
+        lval_t *cached = lmemo_get(lambda->memo, args);
+
+        if (cached)
+        {
+            lval_del(func);
+            lval_del(args);
+            return lval_clone(cached);
+        }
+
+        key = lval_clone(args);
+    }
+
+    lenv_t *frame = lenv_frame(env, lambda->formals, args);
+    lval_t *body = lval_to_sexpr(lval_clone(llambda_code(lambda, env)));
+
+    lval_t *result = lval_eval(frame, body);
+
+    lenv_del(frame);
+
+    // Each call returning a new table or builder must give a different one.
+    if (key && result->type != ERROR && !lval_is_mutable(result))
+        lmemo_put(lambda->memo, key, lval_clone(result));
+    else if (key)
+        lval_del(key);
+
+    lval_del(func);
+
+    return result;
+}
+
+static bool lval_is_text(const lval_t *lval)
+{
+    return lval->type == STRING || lval->type == ROPE;
+}
+
+// Length of a string or a rope.
+static size_t lval_text_length(const lval_t *text)
+{
+    return text->type == ROPE ? text->rope->length : text->string->length;
+}
+
+/// @brief Get the bytes of a string or a rope, followed by a NUL byte.
+/// @param flat set to the text of a rope, flattened for the occasion,
+///        to be freed by the caller. NULL for a string.
+static const char *lval_text_bytes(const lval_t *text, char **flat)
+{
+    *flat = text->type == ROPE ? lrope_flatten(text->rope) : NULL;
+
+    return *flat ? *flat : text->string->text;
+}
+
+static bool lval_text_eq(const lval_t *x, const lval_t *y)
+{
+    if (x->type == STRING && y->type == STRING)
+        return lstr_eq(x->string, y->string);
+
+    if (lval_text_length(x) != lval_text_length(y))
+        return false;
+
+    char *flat_x, *flat_y;
+    bool eq = memcmp(lval_text_bytes(x, &flat_x), lval_text_bytes(y, &flat_y), lval_text_length(x)) == 0;
+
+    free(flat_x);
+    free(flat_y);
+
+    return eq;
+}
+
+// Cache of the hash of a q-expression viewing all of its shared cells, which never change.
+// NULL for other expressions, whose cells can change or are only a slice.
+static size_t *lval_hash_cache(const lval_t *lval)
+{
+    lcells_t *shared = lval->shared;
+
+    if (!shared || lval->cell != shared->cell || lval->count != shared->count)
+        return NULL;
+
+    return &shared->hash;
+}
+
+int lval_eq(lval_t *x, lval_t *y)
+{
+    if (x == y && lval_is_immortal(x))
+        return 1;
+
+    // Ropes are equal to the strings with the same text.
+    if ((x->type == ROPE || y->type == ROPE) && lval_is_text(x) && lval_is_text(y))
+        return lval_text_eq(x, y);
+
+    if (x->type != y->type)
+        return 0;
+
+    // NOTE: non-exhaustive.
+    switch (x->type) {
+        case NUMBER: return x->number == y->number;
+        case BIGNUM: return lbig_cmp(x->big, y->big) == 0;
+        case FLOAT: return x->real == y->real;
+        case ARRAY: return larray_eq(x->array, y->array);
+        // Comparing sequences would force them.
+        case LAZY: return 0;
+        case VECTOR: return lvec_eq(x->vector, y->vector);
+        case MAP: return lmap_eq(x->map, y->map);
+        // Tables are mutable, two of them are only equal if they are the same.
+        case TABLE: return x->table == y->table;
+        case BUILDER: return x->builder == y->builder;
+        case ROPE: return lval_text_eq(x, y);
+        case STRING: return lstr_eq(x->string, y->string);
+        case SYMBOL: return strcmp(x->symbol, y->symbol) == 0;
+        case FUN:
+            if (!x->lambda && !y->lambda) {
+                return x->builtin == y->builtin && x->native == y->native;
+            } else {
+                return 0;
+            }
+        case SEXPR:
+        case QEXPR:
+            if (x->count != y->count)
+                return 0;
+
+            // Views of the same interned literal are equal without looking at their elements.
+            if (x->cell == y->cell && x->shared && x->shared->interned)
+                return 1;
+
+            // Shared cells cache their hash, lists with different hashes differ.
+            if (lval_hash_cache(x) && lval_hash_cache(y) && lval_hash(x) != lval_hash(y))
+                return 0;
+
+            for (unsigned int i = 0; i < x->count; ++i) {
+                if (lval_eq(x->cell[i], y->cell[i]) == 0) {
+                    return 0;
+                }
+            }
+
+            return 1;
+        case ERROR: return strcmp(x->error, y->error);
+    }
+
+    // To please the compiler.
+    return 0;
+}
+
+static size_t hash_bytes(size_t hash, const char *bytes, size_t length)
+{
+    for (size_t i = 0; i < length; ++i)
+        hash = (hash ^ (unsigned char)bytes[i]) * 0x100000001b3UL;
+
+    return hash;
+}
+
+static size_t hash_mix(size_t hash, size_t value)
+{
+    return (hash ^ (value + 0x9e3779b97f4a7c15UL + (hash << 6) + (hash >> 2))) * 0x100000001b3UL;
+}
+
+static size_t hash_float(size_t hash, double real)
+{
+    size_t bits;
+
+    // 0.0 and -0.0 are equal, their bits are not.
+    if (real == 0)
+        return hash;
+
+    memcpy(&bits, &real, sizeof(bits));
+
+    return hash_mix(hash, bits);
+}
+
+// Entries of a map are visited in no particular order, their hashes are combined by a sum.
+static void lval_hash_entry(const lval_t *key, const lval_t *value, void *data)
+{
+    *(size_t *)data += hash_mix(lval_hash(key), lval_hash(value));
+}
+
+/// @brief Compute a structural hash of a lval, consistent with `lval_eq`:
+///        two equal values always have the same hash.
+/// @param lval
+/// @return the hash of the value.
+size_t lval_hash(const lval_t *lval)
+{
+    // Ropes hash like the strings they are equal to.
+    size_t hash = hash_mix(0xcbf29ce484222325UL, lval->type == ROPE ? STRING : lval->type);
+
+    switch (lval->type) {
+        case NUMBER: return hash_mix(hash, (size_t)lval->number);
+        case FLOAT: return hash_float(hash, lval->real);
+        case ARRAY:
+            for (size_t i = 0; i < lval->array->count; ++i)
+            {
+                if (lval->array->kind == ARRAY_INT)
+                    hash = hash_mix(hash, (size_t)lval->array->ints[i]);
+                else
+                    hash = hash_float(hash, lval->array->floats[i]);
+            }
+
+            return hash;
+        case BIGNUM:
+            hash = hash_mix(hash, lval->big->negative);
+
+            for (size_t i = 0; i < lval->big->count; ++i)
+                hash = hash_mix(hash, lval->big->limbs[i]);
+
+            return hash;
+        case LAZY: return hash;
+        case VECTOR:
+            for (size_t i = 0; i < lval->vector->count; ++i)
+                hash = hash_mix(hash, lval_hash(lvec_nth(lval->vector, i)));
+
+            return hash;
+        case MAP: {
+            size_t entries = 0;
+
+            lmap_each(lval->map, &lval_hash_entry, &entries);
+
+            return hash_mix(hash, entries);
+        }
+        case TABLE: return hash_mix(hash, (size_t)lval->table);
+        case BUILDER: return hash_mix(hash, (size_t)lval->builder);
+        case ROPE: {
+            char *text = lrope_flatten(lval->rope);
+
+            hash = hash_bytes(hash, text, lval->rope->length);
+            free(text);
+
+            return hash;
+        }
+        // Strings are immutable, their hash is only computed once.
+        case STRING:
+            if (!lval->string->hash)
+                lval->string->hash = hash_bytes(hash, lval->string->text, lval->string->length);
+
+            return lval->string->hash;
+        case SYMBOL: return hash_bytes(hash, lval->symbol, strlen(lval->symbol));
+        case ERROR: return hash_bytes(hash, lval->error, strlen(lval->error));
+        case FUN:
+            if (lval->builtin)
+                return hash_mix(hash, (size_t)lval->builtin);
+
+            return lval->native ? hash_mix(hash, (size_t)lval->native) : hash;
+        case SEXPR:
+        case QEXPR: {
+            size_t *cache = lval_hash_cache(lval);
+
+            if (cache && *cache)
+                return *cache;
+
+            for (unsigned int i = 0; i < lval->count; ++i)
+                hash = hash_mix(hash, lval_hash(lval->cell[i]));
+
+            if (cache)
+                *cache = hash;
+
+            return hash;
+        }
+    }
+
+    return hash;
+}
+
+static void lval_hashable_entry(const lval_t *key, const lval_t *value, void *data)
+{
+    if (!lval_hashable(value))
+        *(bool *)data = false;
+}
+
+// Whether a value can be a key of a map, that is compared by `lval_eq` to the values it is equal to.
+// Functions and lazy sequences are never equal to anything.
+bool lval_hashable(const lval_t *lval)
+{
+    bool hashable = true;
+
+    switch (lval->type) {
+        case FUN:
+        case LAZY:
+        case SEXPR:
+        case ERROR:
+            return false;
+        case QEXPR:
+            for (size_t i = 0; i < lval->count; ++i) {
+                if (!lval_hashable(lval->cell[i]))
+                    return false;
+            }
+
+            return true;
+        case VECTOR:
+            for (size_t i = 0; i < lval->vector->count; ++i) {
+                if (!lval_hashable(lvec_nth(lval->vector, i)))
+                    return false;
+            }
+
+            return true;
+        case MAP:
+            lmap_each(lval->map, &lval_hashable_entry, &hashable);
+            return hashable;
+        default:
+            return true;
+    }
+}
+
+/// @brief Sum or multiply floats, two lanes at a time with SSE2 when
+///        available, using two registers to overlap the dependency chains.
+/// @param product true to multiply, false to sum.
+static double lval_float_reduce(bool product, const double *values, size_t count)
+{
+    double result = product ? 1 : 0;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    __m128d acc0 = _mm_set1_pd(result);
+    __m128d acc1 = acc0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128d a = _mm_loadu_pd(&values[i]);
+        __m128d b = _mm_loadu_pd(&values[i + 2]);
+
+        acc0 = product ? _mm_mul_pd(acc0, a) : _mm_add_pd(acc0, a);
+        acc1 = product ? _mm_mul_pd(acc1, b) : _mm_add_pd(acc1, b);
+    }
+
+    double lanes[2];
+
+    _mm_storeu_pd(lanes, product ? _mm_mul_pd(acc0, acc1) : _mm_add_pd(acc0, acc1));
+    result = product ? lanes[0] * lanes[1] : lanes[0] + lanes[1];
+#endif
+
+    for (; i < count; ++i)
+        result = product ? result * values[i] : result + values[i];
+
+    return result;
+}
+
+// Check if `add` or `mix` is applied to enough floats to take the vectorized path.
+static bool lval_float_vectorizable(const lval_t *lval, const char *symbol)
+{
+    if (lval->count < LVAL_VECTOR_MIN || (strcmp(symbol, "+") != 0 && strcmp(symbol, "*") != 0))
+        return false;
+
+    for (size_t i = 0; i < lval->count; ++i) {
+        if (lval->cell[i]->type != FLOAT)
+            return false;
+    }
+
+    return true;
+}
+
+/// @brief evaluate an math operator on a list of numbers.
+/// @param lval
+/// @return the result of the evaluation.
+lval_t *builtin_op(lenv_t *env, lval_t *lval, char *symbol)
+{
+    for (unsigned int i = 0; i < lval->count; ++i)
+    {
+        lval_type_t type = lval->cell[i]->type;
+
+        if (type != NUMBER && type != BIGNUM && type != FLOAT)
+        {
+            lval_del(lval);
+            return lval_err("Numerical operators can only be applied to numbers");
+        }
+    }
+
+    if (lval_float_vectorizable(lval, symbol))
+    {
+        double *values = malloc(sizeof(double) * lval->count);
+
+        for (size_t i = 0; i < lval->count; ++i)
+            values[i] = lval->cell[i]->real;
+
+        double result = lval_float_reduce(symbol[0] == '*', values, lval->count);
+
+        free(values);
+        lval_del(lval);
+
+        return lval_float(result);
+    }
+
+    lval_t *first = lval->cell[0];
+    lacc_t acc;
+
+    lacc_init(&acc, first->type == NUMBER ? first->number : 0, first->type == NUMBER ? NULL : first);
+
+    if (lval->count == 1 && strcmp(symbol, "-") == 0)
+    {
+        lacc_negate(&acc);
+    }
+
+    for (unsigned int i = 1; i < lval->count; ++i)
+    {
+        lval_t *next = lval->cell[i];
+
+        if (!lacc_apply(&acc, symbol, next->type == NUMBER ? next->number : 0, next->type == NUMBER ? NULL : next))
+        {
+            if (acc.big)
+                lbig_del(acc.big);
+
+            lval_del(lval);
+            return lval_err("Cannot divide by zero");
+        }
+    }
+
+    lval_del(lval);
+    return lacc_box(&acc, symbol);
+}
+
+/// @brief Apply a numerical operator to an accumulated result, checking for overflows.
+/// @param symbol operator, one of `+ - * / % > >= < <=`.
+/// @return false if the result does not fit a `long` or is a division
+///         by zero, in which case `result` is left untouched.
+bool lval_op_apply(const char *symbol, long *result, long next)
+{
+    long value;
+
+    if (strcmp(symbol, "-") == 0)
+    {
+        if (__builtin_sub_overflow(*result, next, &value))
+            return false;
+    }
+    else if (strcmp(symbol, "+") == 0)
+    {
+        if (__builtin_add_overflow(*result, next, &value))
+            return false;
+    }
+    else if (strcmp(symbol, "*") == 0)
+    {
+        if (__builtin_mul_overflow(*result, next, &value))
+            return false;
+    }
+    else if (strcmp(symbol, "/") == 0 || strcmp(symbol, "%") == 0)
+    {
+        // LONG_MIN / -1 is the only quotient that overflows.
+        if (!next || (next == -1 && *result == LONG_MIN))
+            return false;
+
+        value = symbol[0] == '/' ? *result / next : *result % next;
+    }
+    else if (strcmp(symbol, ">") == 0)
+        value = *result > next;
+    else if (strcmp(symbol, ">=") == 0)
+        value = *result >= next;
+    else if (strcmp(symbol, "<") == 0)
+        value = *result < next;
+    else
+        value = *result <= next;
+
+    *result = value;
+    return true;
+}
+
+lval_t *builtin_op_add(lenv_t *env, lval_t *lval)
+{
+    return builtin_op(env, lval, "+");
+}
+
+lval_t *builtin_op_sub(lenv_t *env, lval_t *lval)
+{
+    return builtin_op(env, lval, "-");
+}
+
+lval_t *builtin_op_div(lenv_t *env, lval_t *lval)
+{
+    return builtin_op(env, lval, "/");
+}
+
+lval_t *builtin_op_mul(lenv_t *env, lval_t *lval)
+{
+    return builtin_op(env, lval, "*");
+}
+
+lval_t *builtin_op_mod(lenv_t *env, lval_t *lval)
+{
+    return builtin_op(env, lval, "%");
+}
+
+lval_t *builtin_op_greater(lenv_t *env, lval_t *lval)
+{
+    return builtin_op(env, lval, ">");
+}
+
+lval_t *builtin_op_greater_equal(lenv_t *env, lval_t *lval)
+{
+    return builtin_op(env, lval, ">=");
+}
+
+lval_t *builtin_op_lesser(lenv_t *env, lval_t *lval)
+{
+    return builtin_op(env, lval, "<");
+}
+
+lval_t *builtin_op_lesser_equal(lenv_t *env, lval_t *lval)
+{
+    return builtin_op(env, lval, "<=");
+}
+
+lval_t *builtin_cmp(lenv_t *env, lval_t *lval, const char *op)
+{
+    LASSERT_NUM_PARAMS(op, lval, 2);
+
+    int result;
+
+    if (strcmp(op, "==") == 0) {
+        result = lval_eq(lval->cell[0], lval->cell[1]);
+    } else if (strcmp(op, "!=") == 0) {
+        result = !lval_eq(lval->cell[0], lval->cell[1]);
+    }
+
+    lval_del(lval);
+
+    return lval_bool(result);
+}
+
+lval_t *builtin_cmp_eq(lenv_t *env, lval_t *lval)
+{
+    return builtin_cmp(env, lval, "==");
+}
+
+lval_t *builtin_cmp_neq(lenv_t *env, lval_t *lval)
+{
+    return builtin_cmp(env, lval, "!=");
+}
+
+/// @brief get the head of a qexpr.
+/// @param argv a single qexpr.
+/// @return a qexpr viewing the head, without copying it.
+lval_t *builtin_head(lenv_t *env, lval_t **argv, size_t argc)
+{
+    if (argv[0]->count == 0)
+        return lval_err("`head` symbol cannot be applied to an empty Q-Expression");
+
+    return lval_view(argv[0], 0, 1);
+}
+
+/// @brief get the tail of a qexpr in O(1).
+/// @param argv a single qexpr.
+/// @return a qexpr viewing the tail, sharing the cells of the argument.
+lval_t *builtin_tail(lenv_t *env, lval_t **argv, size_t argc)
+{
+    if (argv[0]->count == 0)
+        return lval_err("`tail` symbol cannot be applied to an empty Q-Expression");
+
+    return lval_view(argv[0], 1, argv[0]->count - 1);
+}
+
+/// @brief Transform a sexpr into a qexpr.
+/// @param lval
+/// @return a qexpr.
+lval_t *builtin_list(lenv_t *env, lval_t *lval)
+{
+    LASSERT(lval, lval->type == SEXPR, "`list` symbol can only be applied to a S-Expression");
+
+    lval->type = QEXPR;
+    return lval;
+}
+
+/// @brief Evaluate a qexpr by transforming it into a sexpr.
+/// @param argv a single qexpr, taken by the builtin.
+/// @return the result of the evaluation.
+lval_t *builtin_eval(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *q = argv[0];
+
+    argv[0] = NULL;
+
+    return lval_eval(env, lval_to_sexpr(q));
+}
+
+/// @brief join n-qexpr together.
+/// @param argv qexprs whose children are moved to the result.
+/// @return the merged qexpr.
+lval_t *builtin_join(lenv_t *env, lval_t **argv, size_t argc)
+{
+    size_t req_space = 0;
+
+    for (size_t i = 0; i < argc; ++i)
+        req_space += argv[i]->count;
+
+    lval_t *join = lval_qexpr();
+
+    lval_resize_cells(join, req_space);
+
+    for (size_t i = 0; i < argc; ++i)
+    {
+        if (!argv[i]->count)
+            continue;
+
+        lval_unshare(argv[i]);
+        memcpy(&join->cell[join->count], argv[i]->cell, sizeof(lval_t *) * argv[i]->count);
+        join->count += argv[i]->count;
+        argv[i]->count = 0;
+    }
+
+    return join;
+}
+
+lval_t *builtin_var(lenv_t *env, lval_t *lval, const char *function)
+{
+    LASSERT(lval, lval->cell[0]->type == QEXPR, "`def / =` function can only be applied to a Q-Expression of symbols followed by any expression");
+    LASSERT(lval, lval->cell[0]->count == lval->count - 1, "the number of variables must be the same as values when using the `de / =` function");
+
+    lval_t *symbols = lval->cell[0];
+
+    for (size_t i = 0; i < symbols->count; ++i)
+        LASSERT(symbols, symbols->cell[i]->type == SYMBOL, "all members of the q-expression after the `def / =` function must be symbols");
+
+    for (size_t i = 0; i < symbols->count; ++i) {
+        if (strcmp(function, "def") == 0)
+            lenv_def(env, symbols->cell[i], lval->cell[i + 1]);
+        else if (strcmp(function, "=") == 0)
+            lenv_push(env, symbols->cell[i], lval->cell[i + 1]);
+    }
+
+    lval_del(lval);
+    return lval_nil();
+}
+
+lval_t *builtin_def(lenv_t *env, lval_t *lval)
+{
+    return builtin_var(env, lval, "def");
+}
+
+lval_t *builtin_push(lenv_t *env, lval_t *lval)
+{
+    return builtin_var(env, lval, "=");
+}
+
+// Create a lambda function from two q-expr, one for the arguments,
+// and the other for the body.
+//
+// NOTE: you can create a function naming syntax using:
+//       `def {fun} (\ {args body} {def (head args) (\ (tail args) body)})`
+//       It defines a function that creates a lambda from `args` (the first
+//       one is the name of the function) and a `body`.
+//       e.g. `fun {add x y} {+ x y}`
+lval_t *builtin_lambda(lenv_t *env, lval_t *lval)
+{
+    LASSERT_NUM_PARAMS("\\", lval, 2);
+    LASSERT_CHILDREN_TYPE("\\", lval, 0, QEXPR);
+    LASSERT_CHILDREN_TYPE("\\", lval, 1, QEXPR);
+
+    for (size_t i = 0; i < lval->cell[0]->count ;++i)
+    {
+        // FIXME: this is wrong because on error lval wont be freed,
+        //        only lval->cell[0].
+        LASSERT_CHILDREN_TYPE("\\", lval->cell[0], i, SYMBOL);
+    }
+
+    lval_t *formals = lval_pop(lval, 0);
+    lval_t *body = lval_pop(lval, 0);
+    lval_del(lval);
+
+    return lval_lambda(env, formals, body);
+}
+
+/// @brief Define a named lambda in the global environment.
+/// @param lval a q-expr with the name and the formals, followed by a q-expr for the body.
+/// @param function name of the builtin, used for error messages.
+/// @param capacity capacity of the result cache to attach to the lambda, 0 for a regular recipe.
+/// @return the defined lambda.
+lval_t *builtin_define_fn(lenv_t *env, lval_t *lval, const char *function, size_t capacity)
+{
+    LASSERT_NUM_PARAMS(function, lval, 2);
+    LASSERT_CHILDREN_TYPE(function, lval, 0, QEXPR);
+    LASSERT_CHILDREN_TYPE(function, lval, 1, QEXPR);
+    LASSERT(lval, lval->cell[0]->count >= 1, "function '%s' expected a name for the recipe", function);
+
+    for (size_t i = 0; i < lval->cell[0]->count ;++i)
+    {
+        // FIXME: this is wrong because on error lval wont be freed,
+        //        only lval->cell[1].
+        LASSERT_CHILDREN_TYPE(function, lval->cell[0], i, SYMBOL);
+    }
+
+    lval_t *formals = lval_pop(lval, 0);
+    lval_t *name = lval_pop(formals, 0);
+    lval_t *body = lval_pop(lval, 0);
+    lval_t *fun = lval_lambda(env, formals, body);
+
+    // Allocated once the arguments are checked, so that errors do not leak it.
+    fun->lambda->memo = capacity ? lmemo_new(capacity) : NULL;
+
+    lenv_def(env, name, fun);
+    lval_del(name);
+    lval_del(lval);
+
+    return fun;
+}
+
+lval_t *builtin_fn(lenv_t *env, lval_t *lval)
+{
+    return builtin_define_fn(env, lval, "fn", 0);
+}
+
+// Define a recipe that caches its results, keyed on its arguments.
+// An optional third parameter sets how many results are kept before
+// the least recently used ones are evicted.
+// e.g. `memo-recipe {fibonacci n} {...} 4096`
+lval_t *builtin_memo_fn(lenv_t *env, lval_t *lval)
+{
+    size_t capacity = MEMO_DEFAULT_CAPACITY;
+
+    if (lval->count == 3)
+    {
+        LASSERT_CHILDREN_TYPE("memo-recipe", lval, 2, NUMBER);
+        LASSERT(lval, lval->cell[2]->number > 0, "function 'memo-recipe' expected a positive cache capacity");
+
+        capacity = lval->cell[2]->number;
+        lval_del(lval_pop(lval, 2));
+    }
+
+    return builtin_define_fn(env, lval, "memo-recipe", capacity);
+}
+
+// Drop all the results cached by a memoized recipe.
+lval_t *builtin_memo_clear(lenv_t *env, lval_t **argv, size_t argc)
+{
+    if (!argv[0]->lambda || !argv[0]->lambda->memo)
+        return lval_err("function 'memo-clear' expected a memoized recipe");
+
+    lmemo_clear(argv[0]->lambda->memo);
+
+    return lval_nil();
+}
+
+// Return the cache statistics of a memoized recipe as `{hits misses size capacity}`.
+lval_t *builtin_memo_stats(lenv_t *env, lval_t **argv, size_t argc)
+{
+    if (!argv[0]->lambda || !argv[0]->lambda->memo)
+        return lval_err("function 'memo-stats' expected a memoized recipe");
+
+    lmemo_t *memo = argv[0]->lambda->memo;
+    lval_t *stats = lval_qexpr();
+
+    lval_add(stats, lval_num(memo->hits));
+    lval_add(stats, lval_num(memo->misses));
+    lval_add(stats, lval_num(memo->count));
+    lval_add(stats, lval_num(memo->capacity));
+
+    return stats;
+}
+
+// Return `1` if a function has no side effects and only depends on its arguments.
+lval_t *builtin_pure(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return lval_bool(lval_effect(env, argv[0], NULL) == PURE);
+}
+
+// Return the effect of a function: "pure", "reads-globals" or "effectful".
+lval_t *builtin_effect(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return lval_string(leffect_name(lval_effect(env, argv[0], NULL)));
+}
+
+lval_t *builtin_if(lenv_t *env, lval_t *lval)
+{
+    LASSERT_NUM_PARAMS("if", lval, 3);
+    LASSERT_CHILDREN_TYPE("if", lval, 0, NUMBER);
+    LASSERT_CHILDREN_TYPE("if", lval, 1, QEXPR);
+    LASSERT_CHILDREN_TYPE("if", lval, 2, QEXPR);
+
+    lval_t *cond = lval_pop(lval, 0);
+    lval_t *expr = lval_to_sexpr(lval_take(lval, cond->number ? 0 : 1));
+
+    lval_del(cond);
+
+    return lval_eval(env, expr);
+}
+
+// Loop variables of a running `loop`, and room to compute their next values.
+typedef struct
+{
+    lenv_t *frame;
+    size_t count;
+    long *numbers;
+    lval_t **boxed;
+} lloop_t;
+
+// Rebind the loop variables to the arguments of `recur`. Numbers
+// are written over the previous values, without any allocation.
+static lval_t *lval_loop_recur(lloop_t *loop, lval_t *code)
+{
+    if (code->count - 1 != loop->count)
+        return lval_err("function 'recur' expected %zu parameters, got %zu", loop->count, code->count - 1);
+
+    // Every argument is evaluated before rebinding anything.
+    for (size_t i = 0; i < loop->count; ++i)
+    {
+        loop->boxed[i] = lval_eval_unboxed(loop->frame, code->cell[i + 1], false, &loop->numbers[i]);
+
+        if (loop->boxed[i] && loop->boxed[i]->type == ERROR)
+        {
+            lval_t *err = loop->boxed[i];
+
+            for (size_t j = 0; j < i; ++j) {
+                if (loop->boxed[j])
+                    lval_del(loop->boxed[j]);
+            }
+
+            return err;
+        }
+    }
+
+    for (size_t i = 0; i < loop->count; ++i)
+    {
+        lval_t **var = &loop->frame->vals[i];
+
+        if (!loop->boxed[i] && (*var)->type == NUMBER && !lval_is_immortal(*var))
+        {
+            (*var)->number = loop->numbers[i];
+        }
+        else
+        {
+            lval_del(*var);
+            *var = loop->boxed[i] ? loop->boxed[i] : lval_num(loop->numbers[i]);
+        }
+    }
+
+    return NULL;
+}
+
+// Evaluate the tail of a loop body without consuming it.
+// Return NULL when it recurs, or the result of the loop.
+static lval_t *lval_loop_tail(lloop_t *loop, lval_t *code)
+{
+    lbuiltin builtin = lval_peek_builtin(loop->frame, code);
+
+    if (builtin == &builtin_recur)
+        return lval_loop_recur(loop, code);
+
+    if (builtin == &builtin_if && code->count == 4 && code->cell[2]->type == QEXPR && code->cell[3]->type == QEXPR)
+    {
+        long cond;
+        lval_t *boxed = lval_eval_unboxed(loop->frame, code->cell[1], false, &cond);
+
+        if (!boxed)
+            return lval_loop_tail(loop, code->cell[cond ? 2 : 3]);
+
+        if (boxed->type == ERROR)
+            return boxed;
+
+        // Let the builtin report the invalid condition.
+        lval_t *args = lval_add(lval_sexpr(), boxed);
+        lval_add(args, lval_clone(code->cell[2]));
+        lval_add(args, lval_clone(code->cell[3]));
+
+        return builtin_if(loop->frame, args);
+    }
+
+    return lval_eval(loop->frame, lval_to_sexpr(lval_clone(code)));
+}
+
+// Evaluate a body over and over, as long as it ends by calling `recur`
+// with the next values of the loop variables. Variables are declared
+// like with `shelf`, followed by the body.
+// e.g. `loop {i total} 0 0 {if (smaller i 10) {recur (add i 1) (add total i)} {total}}`
+lval_t *builtin_loop(lenv_t *env, lval_t *lval)
+{
+    LASSERT(lval, lval->count >= 2, "function 'loop' expected variables, their values and a body");
+    LASSERT_CHILDREN_TYPE("loop", lval, 0, QEXPR);
+    LASSERT_CHILDREN_TYPE("loop", lval, lval->count - 1, QEXPR);
+    LASSERT(lval, lval->cell[0]->count == lval->count - 2, "the number of variables must be the same as values when using the `loop` function");
+
+    for (size_t i = 0; i < lval->cell[0]->count; ++i)
+        LASSERT(lval, lval->cell[0]->cell[i]->type == SYMBOL, "all members of the q-expression after the `loop` function must be symbols");
+
+    lval_t *formals = lval_pop(lval, 0);
+    lval_t *body = lval_pop(lval, lval->count - 1);
+    lloop_t loop = {
+        .frame = lenv_frame(env, formals, lval),
+        .count = formals->count,
+        .numbers = malloc(sizeof(long) * formals->count),
+        .boxed = malloc(sizeof(lval_t *) * formals->count)};
+    lval_t *result;
+
+    while (!(result = lval_loop_tail(&loop, body)));
+
+    lenv_del(loop.frame);
+    free(loop.numbers);
+    free(loop.boxed);
+    lval_del(formals);
+    lval_del(body);
+
+    return result;
+}
+
+// Only valid in the tail of a `loop` body, where it is handled by the loop itself.
+lval_t *builtin_recur(lenv_t *env, lval_t *lval)
+{
+    lval_del(lval);
+    return lval_err("function 'recur' can only be used at the end of a `loop` body");
+}
+
+lval_t *builtin_load(lenv_t *env, lval_t *lval)
+{
+    LASSERT_NUM_PARAMS("load", lval, 1);
+    LASSERT_CHILDREN_TYPE("load", lval, 0, STRING);
+
+    mpc_result_t r;
+
+    if (mpc_parse_contents(lval->cell[0]->string->text, env->parser->program, &r))
+    {
+        lval_t *expr = lval_read(r.output);
+        mpc_ast_delete(r.output);
+
+        while (expr->count) {
+            lval_t *result = lval_eval(env, lval_pop(expr, 0));   
+
+            if (result->type == ERROR)
+              lval_println(result); 
+
+            lval_del(result);
+        }
+
+        lval_del(expr);
+        lval_del(lval);
+
+        return lval_nil();
+    }
+    else
+    {
+        char *error_message = mpc_err_string(r.error);
+        lval_t *error = lval_err("failed to load file: %s", error_message);
+
+        mpc_err_delete(r.error);
+        free(error_message);
+        lval_del(lval);
+
+        return error;
+    }
+}
+
+static void lval_print(const lval_t *);
+
+lval_t *builtin_print(lenv_t *env, lval_t **argv, size_t argc)
+{
+    for (size_t i = 0; i < argc; ++i) {
+        lval_print(argv[i]);
+        putchar(' ');
+    }
+
+    putchar('\n');
+
+    return lval_nil();
+}
+
+lval_t *builtin_error(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return lval_err("%s", argv[0]->string->text);
+}
+
+/// @brief Call a function on owned arguments, leaving the function untouched.
+///        Builtins using the array calling convention get the arguments
+///        directly, without building an expression around them.
+lval_t *lval_call_argv(lenv_t *env, const lval_t *func, lval_t **argv, size_t argc)
+{
+    if (func->native)
+    {
+        lval_t *result = lval_call_native(env, func->native, argv, argc);
+
+        for (size_t i = 0; i < argc; ++i) {
+            if (argv[i])
+                lval_del(argv[i]);
+        }
+
+        return result;
+    }
+
+    lval_t *args = lval_sexpr();
+
+    lval_resize_cells(args, argc);
+    memcpy(args->cell, argv, sizeof(lval_t *) * argc);
+    args->count = argc;
+
+    return lval_call(env, lval_clone((lval_t *)func), args);
+}
+
+// Apply a function to every element of a q-expr, which is reused to hold the results.
+// e.g. `map (improv {x} {mix x 2}) {1 2 3}`
+lval_t *builtin_map(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *list = argv[1];
+    argv[1] = NULL;
+    lval_unshare(list);
+
+    for (size_t i = 0; i < list->count; ++i)
+    {
+        list->cell[i] = lval_call_argv(env, argv[0], &list->cell[i], 1);
+
+        if (list->cell[i]->type == ERROR)
+            return lval_take(list, i);
+    }
+
+    return list;
+}
+
+// Keep the elements of a q-expr for which a predicate returns a non-zero number.
+// e.g. `filter (improv {x} {bigger x 1}) {1 2 3}`
+lval_t *builtin_filter(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *list = argv[1];
+    size_t kept = 0;
+    argv[1] = NULL;
+    lval_unshare(list);
+
+    for (size_t i = 0; i < list->count; ++i)
+    {
+        lval_t *arg = lval_clone(list->cell[i]);
+        lval_t *keep = lval_call_argv(env, argv[0], &arg, 1);
+
+        if (keep->type != NUMBER)
+        {
+            lval_t *err = keep->type == ERROR
+                ? keep
+                : lval_err("function 'filter' expected its predicate to return a number, not '%s'", lval_type_name(keep->type));
+
+            if (err != keep)
+                lval_del(keep);
+
+            for (size_t j = i; j < list->count; ++j)
+                lval_del(list->cell[j]);
+
+            list->count = kept;
+            lval_del(list);
+
+            return err;
+        }
+
+        if (keep->number)
+            list->cell[kept++] = list->cell[i];
+        else
+            lval_del(list->cell[i]);
+
+        lval_del(keep);
+    }
+
+    list->count = kept;
+
+    return list;
+}
+
+/// @brief Combine the elements of a q-expr with an accumulated value, starting from `init`.
+/// @param right false to call `f acc x` from the first element, true to call `f x acc` from the last.
+static lval_t *builtin_fold(lenv_t *env, lval_t **argv, bool right)
+{
+    lval_t *acc = argv[1];
+    lval_t *list = argv[2];
+    argv[1] = NULL;
+    argv[2] = NULL;
+    lval_unshare(list);
+
+    for (size_t n = 0; n < list->count && acc->type != ERROR; ++n)
+    {
+        size_t i = right ? list->count - 1 - n : n;
+        lval_t *args[2] = {right ? list->cell[i] : acc, right ? acc : list->cell[i]};
+
+        list->cell[i] = NULL;
+        acc = lval_call_argv(env, argv[0], args, 2);
+    }
+
+    lval_del_args(list);
+
+    return acc;
+}
+
+/// @brief Check the list consumed by `fold-left` or `for-each`.
+/// @return NULL if it is a q-expr or a bounded lazy sequence, an error otherwise.
+static lval_t *lval_check_consumed(const char *function, const lval_t *arg, size_t index)
+{
+    if (arg->type == LAZY && !lseq_bounded(arg->seq))
+        return lval_err("function '%s' expected a finite sequence, not an unbounded one", function);
+
+    if (arg->type != LAZY && arg->type != QEXPR)
+        return lval_err("function '%s' expected children at index %ld to be of type 'Q-Expression', not '%s'",
+                        function, index, lval_type_name(arg->type));
+
+    return NULL;
+}
+
+// Fold a lazy sequence, pulling one element at a time instead of forcing it.
+static lval_t *builtin_fold_seq(lenv_t *env, lval_t **argv)
+{
+    lval_t *acc = argv[1];
+    lval_t *element;
+    argv[1] = NULL;
+
+    while (acc->type != ERROR && (element = lseq_next(env, argv[2]->seq)))
+    {
+        if (element->type == ERROR) {
+            lval_del(acc);
+            return element;
+        }
+
+        lval_t *args[2] = {acc, element};
+
+        acc = lval_call_argv(env, argv[0], args, 2);
+    }
+
+    return acc;
+}
+
+// e.g. `fold-left strain 10 {1 2 3}` is `strain (strain (strain 10 1) 2) 3`
+lval_t *builtin_fold_left(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *err = lval_check_consumed("fold-left", argv[2], 2);
+
+    if (err)
+        return err;
+
+    return argv[2]->type == LAZY ? builtin_fold_seq(env, argv) : builtin_fold(env, argv, false);
+}
+
+// e.g. `fold-right strain 10 {1 2 3}` is `strain 1 (strain 2 (strain 3 10))`
+lval_t *builtin_fold_right(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_fold(env, argv, true);
+}
+
+// Call a function on every element of a q-expr for its effects, discarding the results.
+// e.g. `for-each say {1 2 3}`
+lval_t *builtin_for_each(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *err = lval_check_consumed("for-each", argv[1], 1);
+
+    if (err)
+        return err;
+
+    if (argv[1]->type == LAZY)
+    {
+        lval_t *element;
+
+        while ((element = lseq_next(env, argv[1]->seq)))
+        {
+            lval_t *result = element->type == ERROR ? element : lval_call_argv(env, argv[0], &element, 1);
+
+            if (result->type == ERROR)
+                return result;
+
+            lval_del(result);
+        }
+
+        return lval_nil();
+    }
+
+    lval_t *list = argv[1];
+    argv[1] = NULL;
+    lval_unshare(list);
+
+    for (size_t i = 0; i < list->count; ++i)
+    {
+        lval_t *result = lval_call_argv(env, argv[0], &list->cell[i], 1);
+
+        list->cell[i] = NULL;
+
+        if (result->type == ERROR) {
+            lval_del_args(list);
+            return result;
+        }
+
+        lval_del(result);
+    }
+
+    lval_del_args(list);
+
+    return lval_nil();
+}
+
+//  -------------
+// | Transducers |
+//  -------------
+
+// Transducers are q-exprs of steps applied to each element before it is folded,
+// e.g. `comp (mapping f) (filtering p)` is `{mapping f filtering p}`.
+static bool lval_is_xform(const lval_t *xform)
+{
+    if (xform->count % 2)
+        return false;
+
+    for (size_t i = 0; i < xform->count; i += 2)
+    {
+        const lval_t *step = xform->cell[i];
+
+        if (step->type != SYMBOL || xform->cell[i + 1]->type != FUN)
+            return false;
+
+        if (strcmp(step->symbol, "mapping") != 0 && strcmp(step->symbol, "filtering") != 0)
+            return false;
+    }
+
+    return true;
+}
+
+static lval_t *builtin_xform_step(lval_t **argv, const char *step)
+{
+    lval_t *xform = lval_add(lval_qexpr(), lval_sym(step));
+
+    lval_add(xform, argv[0]);
+    argv[0] = NULL;
+
+    return xform;
+}
+
+// Return a transducer applying a function to every element.
+lval_t *builtin_mapping(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_xform_step(argv, "mapping");
+}
+
+// Return a transducer keeping the elements for which a predicate returns a non-zero number.
+lval_t *builtin_filtering(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_xform_step(argv, "filtering");
+}
+
+// Compose transducers, elements go through them from left to right.
+// e.g. `comp (mapping f) (filtering p)` maps before filtering.
+lval_t *builtin_comp(lenv_t *env, lval_t **argv, size_t argc)
+{
+    for (size_t i = 0; i < argc; ++i) {
+        if (!lval_is_xform(argv[i]))
+            return lval_err("function 'comp' expected transducers, not '%s' at index %ld", lval_type_name(argv[i]->type), i);
+    }
+
+    return builtin_join(env, argv, argc);
+}
+
+/// @brief Run an element through the steps of a transducer.
+/// @return the transformed element, NULL if a step filtered it out, or an error.
+static lval_t *lval_xform_apply(lenv_t *env, const lval_t *xform, lval_t *element)
+{
+    for (size_t i = 0; i < xform->count; i += 2)
+    {
+        const lval_t *fun = xform->cell[i + 1];
+
+        if (strcmp(xform->cell[i]->symbol, "mapping") == 0)
+        {
+            element = lval_call_argv(env, fun, &element, 1);
+
+            if (element->type == ERROR)
+                return element;
+
+            continue;
+        }
+
+        lval_t *arg = lval_clone(element);
+        lval_t *keep = lval_call_argv(env, fun, &arg, 1);
+        bool kept = keep->type == NUMBER && keep->number;
+
+        if (keep->type != NUMBER)
+        {
+            lval_del(element);
+
+            if (keep->type == ERROR)
+                return keep;
+
+            lval_del(keep);
+            return lval_err("function 'filtering' expected its predicate to return a number");
+        }
+
+        lval_del(keep);
+
+        if (!kept) {
+            lval_del(element);
+            return NULL;
+        }
+    }
+
+    return element;
+}
+
+/// @brief Fold the elements of a q-expr or a bounded lazy sequence going through
+///        a transducer, in a single pass without building intermediate lists.
+/// e.g. `transduce (comp (mapping f) (filtering p)) add 0 {1 2 3}`
+lval_t *builtin_transduce(lenv_t *env, lval_t **argv, size_t argc)
+{
+    if (!lval_is_xform(argv[0]))
+        return lval_err("function 'transduce' expected a transducer built with `mapping`, `filtering` and `comp`");
+
+    lval_t *err = lval_check_consumed("transduce", argv[3], 3);
+
+    if (err)
+        return err;
+
+    lseq_t *seq = argv[3]->type == LAZY ? argv[3]->seq : NULL;
+    lval_t *list = seq ? NULL : argv[3];
+    lval_t *acc = argv[2];
+    argv[2] = NULL;
+
+    if (list) {
+        argv[3] = NULL;
+        lval_unshare(list);
+    }
+
+    for (size_t i = 0; acc->type != ERROR; ++i)
+    {
+        lval_t *element = seq ? lseq_next(env, seq) : i < list->count ? list->cell[i] : NULL;
+
+        if (!element)
+            break;
+
+        if (list)
+            list->cell[i] = NULL;
+
+        if (element->type != ERROR)
+            element = lval_xform_apply(env, argv[0], element);
+
+        if (!element)
+            continue;
+
+        if (element->type == ERROR) {
+            lval_del(acc);
+            acc = element;
+            break;
+        }
+
+        lval_t *args[2] = {acc, element};
+
+        acc = lval_call_argv(env, argv[1], args, 2);
+    }
+
+    if (list)
+        lval_del_args(list);
+
+    return acc;
+}
+
+// Box the element of a packed array at a given index.
+static lval_t *lval_array_get(const larray_t *array, size_t index)
+{
+    return array->kind == ARRAY_INT ? lval_num(array->ints[index]) : lval_float(array->floats[index]);
+}
+
+// Pack a q-expr of numbers into a contiguous array, of floats if any of them is a float.
+// e.g. `pack {1 2 3}`
+lval_t *builtin_pack(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *q = argv[0];
+    larray_kind_t kind = ARRAY_INT;
+
+    for (size_t i = 0; i < q->count; ++i)
+    {
+        if (q->cell[i]->type == FLOAT)
+            kind = ARRAY_FLOAT;
+        else if (q->cell[i]->type != NUMBER)
+            return lval_err("function 'pack' expected numbers, not '%s' at index %ld", lval_type_name(q->cell[i]->type), i);
+    }
+
+    larray_t *array = larray_new(kind, q->count);
+
+    for (size_t i = 0; i < q->count; ++i)
+    {
+        if (kind == ARRAY_INT)
+            array->ints[i] = q->cell[i]->number;
+        else
+            array->floats[i] = q->cell[i]->type == FLOAT ? q->cell[i]->real : (double)q->cell[i]->number;
+    }
+
+    return lval_array(array);
+}
+
+// Return the elements of a packed array as a q-expr.
+lval_t *builtin_unpack(lenv_t *env, lval_t **argv, size_t argc)
+{
+    larray_t *array = argv[0]->array;
+    lval_t *q = lval_qexpr();
+
+    lval_resize_cells(q, array->count);
+    q->count = array->count;
+
+    for (size_t i = 0; i < array->count; ++i)
+        q->cell[i] = lval_array_get(array, i);
+
+    return q;
+}
+
+// Number of elements of a q-expr, a packed array or a vector.
+static size_t lval_length(const lval_t *list)
+{
+    switch (list->type) {
+        case ARRAY: return list->array->count;
+        case VECTOR: return list->vector->count;
+        default: return list->count;
+    }
+}
+
+// Return the element of a q-expr, a packed array or a vector at a given index.
+static lval_t *lval_nth(const lval_t *list, size_t index)
+{
+    switch (list->type) {
+        case ARRAY: return lval_array_get(list->array, index);
+        case VECTOR: return lval_clone(lvec_nth(list->vector, index));
+        default: return lval_clone(list->cell[index]);
+    }
+}
+
+// Return the number of elements of a q-expr, a packed array or a vector.
+lval_t *builtin_length(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return lval_num(lval_length(argv[0]));
+}
+
+// Return the element of a q-expr, a packed array or a vector at a zero-based index.
+// e.g. `nth {a b c} 1`
+lval_t *builtin_nth(lenv_t *env, lval_t **argv, size_t argc)
+{
+    size_t count = lval_length(argv[0]);
+    long index = argv[1]->number;
+
+    if (index < 0 || (size_t)index >= count)
+        return lval_err("function 'nth' expected an index between 0 and %ld, got %ld", (long)count - 1, index);
+
+    return lval_nth(argv[0], index);
+}
+
+// Return the last element of a q-expr, a packed array or a vector.
+lval_t *builtin_last(lenv_t *env, lval_t **argv, size_t argc)
+{
+    size_t count = lval_length(argv[0]);
+
+    if (!count)
+        return lval_err("`last` symbol cannot be applied to an empty list");
+
+    return lval_nth(argv[0], count - 1);
+}
+
+// Return the elements of a q-expr, a packed array or a vector from index `start` up to, excluding, `end`.
+// A q-expr is sliced in O(1), as a view over the same elements.
+// e.g. `slice {a b c d} 1 3`
+lval_t *builtin_slice(lenv_t *env, lval_t **argv, size_t argc)
+{
+    size_t count = lval_length(argv[0]);
+    long start = argv[1]->number;
+    long end = argv[2]->number;
+
+    if (start < 0 || start > end || (size_t)end > count)
+        return lval_err("function 'slice' expected 0 <= start <= end <= %ld, got %ld and %ld", (long)count, start, end);
+
+    if (argv[0]->type == ARRAY)
+    {
+        larray_t *array = argv[0]->array;
+        larray_t *slice = larray_new(array->kind, end - start);
+
+        if (end > start)
+            memcpy(slice->ints, &array->ints[start], sizeof(int64_t) * (end - start));
+
+        return lval_array(slice);
+    }
+
+    if (argv[0]->type == VECTOR)
+    {
+        lvec_t *slice = lvec_new();
+
+        for (long i = start; i < end; ++i)
+            lvec_conj(slice, lval_nth(argv[0], i));
+
+        return lval_vector(slice);
+    }
+
+    return lval_view(argv[0], start, end - start);
+}
+
+// Return the elements of a q-expr, a packed array or a vector in reverse order.
+// A q-expr is reversed in place.
+lval_t *builtin_reverse(lenv_t *env, lval_t **argv, size_t argc)
+{
+    if (argv[0]->type == ARRAY)
+    {
+        larray_t *array = argv[0]->array;
+        larray_t *reversed = larray_new(array->kind, array->count);
+
+        for (size_t i = 0; i < array->count; ++i)
+            reversed->ints[i] = array->ints[array->count - 1 - i];
+
+        return lval_array(reversed);
+    }
+
+    if (argv[0]->type == VECTOR)
+    {
+        lvec_t *reversed = lvec_new();
+
+        for (size_t i = argv[0]->vector->count; i > 0; --i)
+            lvec_conj(reversed, lval_nth(argv[0], i - 1));
+
+        return lval_vector(reversed);
+    }
+
+    lval_t *list = argv[0];
+    argv[0] = NULL;
+    lval_unshare(list);
+
+    for (size_t i = 0; i < list->count / 2; ++i)
+    {
+        lval_t *swap = list->cell[i];
+
+        list->cell[i] = list->cell[list->count - 1 - i];
+        list->cell[list->count - 1 - i] = swap;
+    }
+
+    return list;
+}
+
+//  ------
+// | Maps |
+//  ------
+
+/// @brief Check that a value can be a key of a map.
+/// @return NULL if it can, an error otherwise.
+static lval_t *lval_check_key(const char *function, const lval_t *key)
+{
+    if (!lval_hashable(key))
+        return lval_err("function '%s' expected a key that can be compared, not '%s'", function, lval_type_name(key->type));
+
+    return NULL;
+}
+
+// Return a map of the keys and values of a q-expr alternating them.
+// e.g. `dict {a 1 b 2}`
+lval_t *builtin_dict(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *pairs = argv[0];
+
+    if (pairs->count % 2)
+        return lval_err("function 'dict' expected keys and values in pairs, got %ld elements", pairs->count);
+
+    for (size_t i = 0; i < pairs->count; i += 2)
+    {
+        lval_t *err = lval_check_key("dict", pairs->cell[i]);
+
+        if (err)
+            return err;
+    }
+
+    lmap_t *map = lmap_new();
+
+    argv[0] = NULL;
+    lval_unshare(pairs);
+
+    for (size_t i = 0; i < pairs->count; i += 2)
+    {
+        lmap_assoc(map, pairs->cell[i], pairs->cell[i + 1]);
+        pairs->cell[i] = NULL;
+        pairs->cell[i + 1] = NULL;
+    }
+
+    lval_del_args(pairs);
+
+    return lval_map(map);
+}
+
+// Return the value of a key in a map, in O(log32 n).
+// A missing key gives the default value if there is one, `{}` otherwise.
+// e.g. `get m a` or `get m a 0`
+lval_t *builtin_get(lenv_t *env, lval_t **argv, size_t argc)
+{
+    if (argc > 3)
+        return lval_err("function 'get' expected at most 3 parameters, got %ld", argc);
+
+    lval_t *value = lmap_get(argv[0]->map, argv[1]);
+
+    if (value)
+        return lval_clone(value);
+
+    if (argc < 3)
+        return lval_empty();
+
+    value = argv[2];
+    argv[2] = NULL;
+
+    return value;
+}
+
+// `assoc` on a map.
+static lval_t *builtin_map_assoc(lval_t **argv)
 {
-    if (lval->type == SYMBOL) {
-        lval_t *val = lenv_get(env, lval->symbol);
-        lval_del(lval);
-        return val;
-    }
+    lval_t *err = lval_check_key("assoc", argv[1]);
 
-    if (lval->type == SEXPR)
-        return lval_eval_sexpr(env, lval);
+    if (err)
+        return err;
 
-    return lval;
+    lval_t *map = argv[0];
+    argv[0] = NULL;
+
+    lmap_assoc(map->map, argv[1], argv[2]);
+    argv[1] = NULL;
+    argv[2] = NULL;
+
+    return map;
 }
 
-// Evaluate a s-expr. The first element of an s-expr must be a function.
-lval_t *lval_eval_sexpr(lenv_t *env, lval_t *lval)
+// Return a map without a key. It shares all but one path of nodes with the original map.
+// e.g. `dissoc m a`
+lval_t *builtin_dissoc(lenv_t *env, lval_t **argv, size_t argc)
 {
-    for (unsigned int i = 0; i < lval->count; ++i)
-    {
-        lval->cell[i] = lval_eval(env, lval->cell[i]);
+    lval_t *map = argv[0];
+    argv[0] = NULL;
 
-        if (lval->cell[i]->type == ERROR)
-            return lval_take(lval, i);
-    }
+    lmap_dissoc(map->map, argv[1]);
 
-    if (lval->count == 0)
-    {
-        return lval;
-    }
+    return map;
+}
 
-    if (lval->count == 1)
-    {
-        return lval_take(lval, 0);
-    }
+static void lval_add_key(const lval_t *key, const lval_t *value, void *data)
+{
+    lval_add(data, lval_clone((lval_t *)key));
+}
 
-    lval_t *first = lval_pop(lval, 0);
+// Return the keys of a map as a q-expr, in no particular order.
+lval_t *builtin_keys(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *keys = lval_qexpr();
 
-    if (first->type != FUN)
-    {
-        lval_del(first);
-        lval_del(lval);
-        return lval_err("The first element of a S-Expression must be a function");
-    }
+    lmap_each(argv[0]->map, &lval_add_key, keys);
 
-    return lval_call(env, first, lval);
+    return keys;
 }
 
-// TODO: Could implement partially initialized functions like in the book. (or currying)
-//       See https://buildyourownlisp.com/chapter12_functions
-lval_t *lval_call(lenv_t *env, lval_t *func, lval_t *args)
+static void lmap_assoc_entry(const lval_t *key, const lval_t *value, void *data)
 {
-    if (func->builtin)
-        return func->builtin(env, args);
+    lmap_assoc(data, lval_clone((lval_t *)key), lval_clone((lval_t *)value));
+}
+
+// Return the entries of several maps in one map, the value of a key
+// is the one of the last map having it.
+// e.g. `merge defaults options`
+lval_t *builtin_merge(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *map = argv[0];
+    argv[0] = NULL;
 
-    LASSERT(func, func->formals->count == args->count,
-        "lambda expected %ld parameter, got %ld", func->formals->count, args->count
-    );
+    for (size_t i = 1; i < argc; ++i)
+        lmap_each(argv[i]->map, &lmap_assoc_entry, map->map);
 
-    for (size_t i = 0; i < args->count; ++i)
-    {
-        lenv_push(func->env, func->formals->cell[i], args->cell[i]);
-    }
+    return map;
+}
 
-    lval_del(args);
+// Return the structural hash of a value, the same for all the values equal to it.
+// e.g. `same (hash {1 2}) (hash (list 1 2))`
+lval_t *builtin_hash(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *err = lval_check_key("hash", argv[0]);
 
-    func->env->parent = env;
+    if (err)
+        return err;
 
-    return builtin_eval(func->env, lval_add(lval_sexpr(), lval_clone(func->body)));
+    return lval_num((long)lval_hash(argv[0]));
 }
 
-int lval_eq(lval_t *x, lval_t *y)
+//  -------------
+// | Hash tables |
+//  -------------
+
+// Return an empty hash table, with room for a number of entries.
+// e.g. `ht-new 1000000`, or `ht-new 0` if the size is unknown.
+lval_t *builtin_ht_new(lenv_t *env, lval_t **argv, size_t argc)
 {
-    if (x->type != y->type)
-        return 0;
+    if (argv[0]->number < 0)
+        return lval_err("function 'ht-new' expected a size of at least 0, got %ld", argv[0]->number);
 
-    // NOTE: non-exhaustive.
-    switch (x->type) {
-        case NUMBER: return x->number == y->number;
-        case STRING: return strcmp(x->string, y->string) == 0;
-        case SYMBOL: return strcmp(x->symbol, y->symbol) == 0;
-        case FUN:
-            if (x->builtin != NULL && y->builtin != NULL) {
-                return x->builtin == y->builtin;
-            } else {
-                return 0;
-            }
-        case SEXPR:
-        case QEXPR:
-            if (x->count != y->count)
-                return 0;
+    return lval_table(ltable_new(argv[0]->number));
+}
 
-            for (unsigned int i = 0; i < x->count; ++i) {
-                if (lval_eq(x->cell[i], y->cell[i]) == 0) {
-                    return 0;
-                }
-            }
+// Associate a value to a key in a hash table, in place. Return the table.
+// e.g. `ht-put! t "key" 1`
+lval_t *builtin_ht_put(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *err = lval_check_key("ht-put!", argv[1]);
 
-            return 1;
-        case ERROR: return strcmp(x->error, y->error);
-    }
+    if (err)
+        return err;
 
-    // To please the compiler.
-    return 0;
+    ltable_put(argv[0]->table, argv[1], argv[2]);
+    argv[1] = NULL;
+    argv[2] = NULL;
+
+    lval_t *table = argv[0];
+    argv[0] = NULL;
+
+    return table;
 }
 
-/// @brief evaluate an math operator on a list of numbers.
-/// @param lval
-/// @return the result of the evaluation.
-lval_t *builtin_op(lenv_t *env, lval_t *lval, char *symbol)
+// Return the value of a key in a hash table.
+// A missing key gives the default value if there is one, `{}` otherwise.
+// e.g. `ht-get t "key"` or `ht-get t "key" 0`
+lval_t *builtin_ht_get(lenv_t *env, lval_t **argv, size_t argc)
 {
-    for (unsigned int i = 0; i < lval->count; ++i)
-    {
-        if (lval->cell[i]->type != NUMBER)
-        {
-            lval_del(lval);
-            return lval_err("Numerical operators can only be applied to numbers");
-        }
-    }
+    if (argc > 3)
+        return lval_err("function 'ht-get' expected at most 3 parameters, got %ld", argc);
 
-    lval_t *result = lval_pop(lval, 0);
+    lval_t *value = ltable_get(argv[0]->table, argv[1]);
 
-    if (lval->count == 0 && strcmp(symbol, "-") == 0)
-    {
-        result->number = -result->number;
+    if (value)
+        return value;
+
+    if (argc < 3)
+        return lval_empty();
+
+    value = argv[2];
+    argv[2] = NULL;
+
+    return value;
+}
+
+// Replace the value of a key in a hash table by a function applied to it,
+// or to a default value if the key is missing. Return the table.
+// e.g. `ht-update! counts word (improv {n} {add n 1}) 0`
+lval_t *builtin_ht_update(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *err = lval_check_key("ht-update!", argv[1]);
+
+    if (err)
+        return err;
+
+    lval_t *value = ltable_get(argv[0]->table, argv[1]);
+
+    if (!value) {
+        value = argv[3];
+        argv[3] = NULL;
     }
 
-    while (lval->count != 0)
+    // The function may change the table, the key is only looked up again once it returns.
+    value = lval_call_argv(env, argv[2], &value, 1);
+
+    if (value->type == ERROR)
+        return value;
+
+    ltable_put(argv[0]->table, argv[1], value);
+    argv[1] = NULL;
+
+    lval_t *table = argv[0];
+    argv[0] = NULL;
+
+    return table;
+}
+
+// Return the number of entries of a hash table.
+lval_t *builtin_ht_count(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return lval_num(argv[0]->table->count);
+}
+
+// Return the entries of a hash table as a q-expr of `{key value}` pairs, in no particular order.
+// e.g. `for-each (improv {entry} {say entry}) (ht-entries t)`
+lval_t *builtin_ht_entries(lenv_t *env, lval_t **argv, size_t argc)
+{
+    const ltable_t *table = argv[0]->table;
+    lval_t *entries = lval_qexpr();
+
+    for (size_t i = 0; i < table->capacity; ++i)
     {
-        lval_t *next = lval_pop(lval, 0);
+        const ltable_slot_t *slot = &table->slots[i];
 
-        if (strcmp(symbol, "-") == 0)
-            result->number -= next->number;
-        else if (strcmp(symbol, "+") == 0)
-            result->number += next->number;
-        else if (strcmp(symbol, "*") == 0)
-            result->number *= next->number;
-        else if (strcmp(symbol, "/") == 0)
-            if (next->number)
-                result->number /= next->number;
-            else
-            {
-                lval_del(next);
-                lval_del(result);
-                lval_del(lval);
-                return lval_err("Cannot divide by zero");
-            }
-        else if (strcmp(symbol, "%") == 0)
-            result->number %= next->number;
-        else if (strcmp(symbol, ">") == 0)
-            result->number = result->number > next->number;
-        else if (strcmp(symbol, ">=") == 0)
-            result->number = result->number >= next->number;
-        else if (strcmp(symbol, "<") == 0)
-            result->number = result->number < next->number;
-        else if (strcmp(symbol, "<=") == 0)
-            result->number = result->number <= next->number;
-
-        // NOTE: No need for a else statement here, since
-        //       this function can only be called from
-        //       a valid symbol.
-        lval_del(next);
+        if (slot->key) {
+            lval_t *entry = lval_add(lval_qexpr(), ltable_unpack(slot->key));
+            lval_add(entries, lval_add(entry, ltable_unpack(slot->value)));
+        }
     }
 
-    lval_del(lval);
-    return result;
+    return entries;
 }
 
-lval_t *builtin_op_add(lenv_t *env, lval_t *lval)
+//  ---------
+// | Strings |
+//  ---------
+
+// Return the rope of a string or a rope, with a reference for the caller.
+static lrope_t *lval_text_rope(const lval_t *text)
 {
-    return builtin_op(env, lval, "+");
+    return text->type == ROPE ? lrope_ref(text->rope) : lrope_leaf(text->string->text, text->string->length);
 }
 
-lval_t *builtin_op_sub(lenv_t *env, lval_t *lval)
+// Return a rope as a lval, a plain string if it is short enough to be a single leaf.
+// Takes ownership of the rope.
+static lval_t *lval_text(lrope_t *rope)
 {
-    return builtin_op(env, lval, "-");
+    if (rope->length > LROPE_LEAF_MAX)
+        return lval_rope(rope);
+
+    char *text = lrope_flatten(rope);
+    lval_t *string = lval_string_n(text, rope->length);
+
+    free(text);
+    lrope_unref(rope);
+
+    return string;
 }
 
-lval_t *builtin_op_div(lenv_t *env, lval_t *lval)
+// Concatenate strings and ropes. Long results are ropes sharing the nodes of the ropes
+// they are made of, so that concatenating them again does not copy their text.
+// e.g. `concat "flour" " and " "eggs"`
+lval_t *builtin_concat(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_op(env, lval, "/");
+    lrope_t *rope = lval_text_rope(argv[0]);
+
+    for (size_t i = 1; i < argc; ++i)
+        rope = lrope_concat(rope, lval_text_rope(argv[i]));
+
+    return lval_text(rope);
 }
 
-lval_t *builtin_op_mul(lenv_t *env, lval_t *lval)
+// Return the part of a string or a rope from index `start` up to, excluding, `end`.
+// e.g. `substr "pepper" 0 3`
+lval_t *builtin_substr(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_op(env, lval, "*");
+    size_t length = lval_text_length(argv[0]);
+    long start = argv[1]->number;
+    long end = argv[2]->number;
+
+    if (start < 0 || start > end || (size_t)end > length)
+        return lval_err("function 'substr' expected 0 <= start <= end <= %ld, got %ld and %ld", (long)length, start, end);
+
+    if (argv[0]->type == STRING)
+        return lval_string_n(argv[0]->string->text + start, end - start);
+
+    return lval_text(lrope_sub(argv[0]->rope, start, end));
 }
 
-lval_t *builtin_op_mod(lenv_t *env, lval_t *lval)
+// Return the number of bytes of a string or a rope.
+lval_t *builtin_str_len(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_op(env, lval, "%");
+    return lval_num(lval_text_length(argv[0]));
 }
 
-lval_t *builtin_op_greater(lenv_t *env, lval_t *lval)
+// Return the first occurrence of a non-empty separator in a text up to `end`, NULL if there is none.
+static const char *lval_text_find(const char *text, const char *end, const char *separator, size_t length)
 {
-    return builtin_op(env, lval, ">");
+    while ((size_t)(end - text) >= length)
+    {
+        text = memchr(text, separator[0], end - text - length + 1);
+
+        if (!text)
+            return NULL;
+
+        if (memcmp(text, separator, length) == 0)
+            return text;
+
+        ++text;
+    }
+
+    return NULL;
 }
 
-lval_t *builtin_op_greater_equal(lenv_t *env, lval_t *lval)
+// Split a string or a rope around a separator, into a q-expr of strings.
+// e.g. `str-split "salt,pepper" ","`
+lval_t *builtin_str_split(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_op(env, lval, ">=");
+    size_t length = lval_text_length(argv[1]);
+
+    if (!length)
+        return lval_err("function 'str-split' expected a non-empty separator");
+
+    char *flat_text, *flat_separator;
+    const char *text = lval_text_bytes(argv[0], &flat_text);
+    const char *separator = lval_text_bytes(argv[1], &flat_separator);
+    const char *start = text;
+    const char *end = text + lval_text_length(argv[0]);
+    lval_t *parts = lval_qexpr();
+
+    for (const char *match; (match = lval_text_find(start, end, separator, length)); start = match + length)
+        lval_add(parts, lval_string_n(start, match - start));
+
+    lval_add(parts, lval_string_n(start, end - start));
+
+    free(flat_text);
+    free(flat_separator);
+
+    return parts;
 }
 
-lval_t *builtin_op_lesser(lenv_t *env, lval_t *lval)
+// Return an empty string builder, with room for a number of bytes.
+// e.g. `sb-new 4096`, or `sb-new 0` if the size is unknown.
+lval_t *builtin_sb_new(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_op(env, lval, "<");
+    if (argv[0]->number < 0)
+        return lval_err("function 'sb-new' expected a size of at least 0, got %ld", argv[0]->number);
+
+    return lval_builder(lbuilder_new(argv[0]->number));
 }
 
-lval_t *builtin_op_lesser_equal(lenv_t *env, lval_t *lval)
+// Append strings and ropes to a string builder, in place, in amortized O(1)
+// for each byte. Return the builder.
+// e.g. `sb-append! b "salt" ", "`
+lval_t *builtin_sb_append(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_op(env, lval, "<=");
+    lbuilder_t *builder = argv[0]->builder;
+
+    for (size_t i = 1; i < argc; ++i)
+    {
+        if (argv[i]->type == ROPE)
+            lbuilder_append_rope(builder, argv[i]->rope);
+        else
+            lbuilder_append(builder, argv[i]->string->text, argv[i]->string->length);
+    }
+
+    lval_t *lval = argv[0];
+    argv[0] = NULL;
+
+    return lval;
 }
 
-lval_t *builtin_cmp(lenv_t *env, lval_t *lval, const char *op)
+// Return the text appended to a string builder as a string.
+lval_t *builtin_sb_build(lenv_t *env, lval_t **argv, size_t argc)
 {
-    LASSERT_NUM_PARAMS(op, lval, 2);
+    return lval_string_n(argv[0]->builder->text, argv[0]->builder->length);
+}
 
-    int result;
+//  ---------
+// | Vectors |
+//  ---------
 
-    if (strcmp(op, "==") == 0) {
-        result = lval_eq(lval->cell[0], lval->cell[1]);
-    } else if (strcmp(op, "!=") == 0) {
-        result = !lval_eq(lval->cell[0], lval->cell[1]);
+// Return a persistent vector of the arguments.
+// e.g. `vector 1 2 3`
+lval_t *builtin_vector(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lvec_t *vec = lvec_new();
+
+    for (size_t i = 0; i < argc; ++i) {
+        lvec_conj(vec, argv[i]);
+        argv[i] = NULL;
     }
 
-    lval_del(lval);
+    return lval_vector(vec);
+}
+
+// Return a persistent vector of the elements of a q-expr, a packed array or a vector.
+// e.g. `vec {1 2 3}`
+lval_t *builtin_vec(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lvec_t *vec = lvec_new();
+    size_t count = lval_length(argv[0]);
 
-    return lval_num(result);
+    for (size_t i = 0; i < count; ++i)
+        lvec_conj(vec, lval_nth(argv[0], i));
+
+    return lval_vector(vec);
 }
 
-lval_t *builtin_cmp_eq(lenv_t *env, lval_t *lval)
+// Return a vector with elements appended, in amortized O(1) each.
+// It shares all but its last nodes with the original vector.
+// e.g. `conj v 4 5`
+lval_t *builtin_conj(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_cmp(env, lval, "==");
+    lval_t *vector = argv[0];
+    argv[0] = NULL;
+
+    for (size_t i = 1; i < argc; ++i) {
+        lvec_conj(vector->vector, argv[i]);
+        argv[i] = NULL;
+    }
+
+    return vector;
 }
 
-lval_t *builtin_cmp_neq(lenv_t *env, lval_t *lval)
+// Return a vector with the element at a zero-based index replaced, in O(log32 n),
+// or a map with a value associated to a key.
+// They share all but one path of nodes with the original vector or map.
+// e.g. `assoc v 1 x`, `assoc v (length v) x` to append, or `assoc m "key" x`.
+lval_t *builtin_assoc(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_cmp(env, lval, "!=");
+    if (argv[0]->type == MAP)
+        return builtin_map_assoc(argv);
+
+    if (argv[0]->type != VECTOR || argv[1]->type != NUMBER)
+        return lval_err("function 'assoc' expected a vector and an index or a map and a key, not '%s' and '%s'",
+                        lval_type_name(argv[0]->type), lval_type_name(argv[1]->type));
+
+    size_t count = argv[0]->vector->count;
+    long index = argv[1]->number;
+
+    if (index < 0 || (size_t)index > count)
+        return lval_err("function 'assoc' expected an index between 0 and %ld, got %ld", (long)count, index);
+
+    lval_t *vector = argv[0];
+    argv[0] = NULL;
+
+    if ((size_t)index == count)
+        lvec_conj(vector->vector, argv[2]);
+    else
+        lvec_assoc(vector->vector, index, argv[2]);
+
+    argv[2] = NULL;
+
+    return vector;
 }
 
-/// @brief get the head of a qexpr and deletes the tail.
-/// @param lval
-/// @return the popped head from a qexpr.
-lval_t *builtin_head(lenv_t *env, lval_t *lval)
+// Return the numbers from `start` up to, excluding, `end`, computed on demand.
+// e.g. `range 5`, `range 1 5` or `range 10 0 -2`
+lval_t *builtin_range(lenv_t *env, lval_t **argv, size_t argc)
 {
-    LASSERT(lval, lval->count == 1 && lval->cell[0]->type == QEXPR, "`head` symbol can only be applied to one Q-Expression");
-    LASSERT(lval, lval->cell[0]->count >= 1, "`head` symbol cannot be applied to an empty Q-Expression");
+    if (argc > 3)
+        return lval_err("function 'range' expected at most 3 parameters, got %ld", argc);
 
-    lval_t *q = lval_take(lval, 0);
+    long start = argc > 1 ? argv[0]->number : 0;
+    long end = argc > 1 ? argv[1]->number : argv[0]->number;
+    long step = argc > 2 ? argv[2]->number : 1;
 
-    while (q->count > 1)
-    {
-        lval_del(lval_pop(q, 1));
-    }
+    if (!step)
+        return lval_err("function 'range' expected a non-zero step");
 
-    return q;
+    return lval_lazy(lseq_range(start, end, step));
 }
 
-/// @brief get the tail of a qexpr and deletes the head.
-/// @param lval
-/// @return the tail of a qexpr.
-lval_t *builtin_tail(lenv_t *env, lval_t *lval)
+// Return the unbounded sequence of `x`, `f x`, `f (f x)`...
+// e.g. `iterate (improv {x} {mix x 2}) 1`
+lval_t *builtin_iterate(lenv_t *env, lval_t **argv, size_t argc)
 {
-    LASSERT(lval, lval->count == 1 && lval->cell[0]->type == QEXPR, "`tail` symbol can only be applied to one Q-Expression");
-    LASSERT(lval, lval->cell[0]->count >= 1, "`tail` symbol cannot be applied to an empty Q-Expression");
+    lseq_t *seq = lseq_iterate(argv[0], argv[1]);
 
-    lval_t *q = lval_take(lval, 0);
+    argv[0] = NULL;
+    argv[1] = NULL;
 
-    lval_del(lval_pop(q, 0));
+    return lval_lazy(seq);
+}
 
-    return q;
+/// @brief Get the sequence transformed by a lazy builtin.
+/// @return NULL with an error in `err` if the argument is neither a lazy sequence nor a q-expr.
+static lseq_t *lseq_of(const char *function, lval_t *arg, lval_t **err)
+{
+    if (arg->type == LAZY)
+        return lseq_clone(arg->seq);
+
+    if (arg->type == QEXPR)
+        return lseq_list(lval_clone(arg));
+
+    *err = lval_err("function '%s' expected a lazy sequence or a q-expression, not '%s'", function, lval_type_name(arg->type));
+    return NULL;
 }
 
-/// @brief Transform a sexpr into a qexpr.
-/// @param lval
-/// @return a qexpr.
-lval_t *builtin_list(lenv_t *env, lval_t *lval)
+static lval_t *builtin_lazy_count(lval_t **argv, const char *function, lseq_kind_t kind)
 {
-    LASSERT(lval, lval->type == SEXPR, "`list` symbol can only be applied to a S-Expression");
+    lval_t *err;
 
-    lval->type = QEXPR;
-    return lval;
+    if (argv[0]->number < 0)
+        return lval_err("function '%s' expected a positive count, got %ld", function, argv[0]->number);
+
+    lseq_t *source = lseq_of(function, argv[1], &err);
+
+    return source ? lval_lazy(lseq_wrap(kind, source, argv[0]->number, NULL)) : err;
 }
 
-/// @brief Evaluate a qexpr by transforming it into a sexpr.
-/// @param lval
-/// @return the result of the evaluation.
-lval_t *builtin_eval(lenv_t *env, lval_t *lval)
+// Return the first elements of a sequence, at most `n`.
+// e.g. `take 3 (iterate (improv {x} {add x 1}) 0)`
+lval_t *builtin_take(lenv_t *env, lval_t **argv, size_t argc)
 {
-    LASSERT(lval, lval->count == 1 && lval->cell[0]->type == QEXPR, "`eval` symbol can only be applied to a Q-Expression");
+    return builtin_lazy_count(argv, "take", LSEQ_TAKE);
+}
 
-    lval_t *q = lval_take(lval, 0);
-    q->type = SEXPR;
-    return lval_eval(env, q);
+// Return the elements of a sequence after the first `n`.
+lval_t *builtin_drop(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_lazy_count(argv, "drop", LSEQ_DROP);
 }
 
-/// @brief join n-qexpr together.
-/// @param lval
-/// @return the merged qexpr.
-lval_t *builtin_join(lenv_t *env, lval_t *lval)
+static lval_t *builtin_lazy_fun(lval_t **argv, const char *function, lseq_kind_t kind)
+{
+    lval_t *err;
+    lseq_t *source = lseq_of(function, argv[1], &err);
+
+    if (!source)
+        return err;
+
+    lseq_t *seq = lseq_wrap(kind, source, 0, argv[0]);
+
+    argv[0] = NULL;
+
+    return lval_lazy(seq);
+}
+
+// Apply a function to the elements of a sequence, as they are pulled.
+lval_t *builtin_lazy_map(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_lazy_fun(argv, "lazy-map", LSEQ_MAP);
+}
+
+// Keep the elements of a sequence for which a predicate returns a non-zero number, as they are pulled.
+lval_t *builtin_lazy_filter(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_lazy_fun(argv, "lazy-filter", LSEQ_FILTER);
+}
+
+// Compute all the elements of a bounded lazy sequence into a q-expr.
+// e.g. `force (take 3 (range 10))`
+lval_t *builtin_force(lenv_t *env, lval_t **argv, size_t argc)
+{
+    lval_t *err = lval_check_consumed("force", argv[0], 0);
+
+    if (err)
+        return err;
+
+    if (argv[0]->type == QEXPR)
+    {
+        lval_t *list = argv[0];
+        argv[0] = NULL;
+        return list;
+    }
+
+    lval_t *list = lval_qexpr();
+    size_t capacity = 0;
+    lval_t *element;
+
+    while ((element = lseq_next(env, argv[0]->seq)))
+    {
+        if (element->type == ERROR) {
+            lval_del(list);
+            return element;
+        }
+
+        if (list->count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : LVAL_VECTOR_MIN;
+            lval_resize_cells(list, capacity);
+        }
+
+        list->cell[list->count++] = element;
+    }
+
+    return list;
+}
+
+// Sum the integers of an array exactly, once the kernel overflowed.
+static lval_t *lval_array_sum_big(const larray_t *array)
 {
-    unsigned int req_space = 0;
+    lacc_t acc;
 
-    for (unsigned int i = 0; i < lval->count; ++i)
-    {
-        LASSERT(lval, lval->cell[i]->type == QEXPR, "`join` symbol can only be applied to Q-Expressions")
-        req_space += lval->cell[i]->count;
-    }
+    lacc_init(&acc, 0, NULL);
 
-    lval_t *join = lval_qexpr();
+    for (size_t i = 0; i < array->count; ++i)
+        lacc_apply(&acc, "+", array->ints[i], NULL);
 
-    join->count = req_space;
-    join->cell = malloc(sizeof(lval_t *) * req_space);
+    return lacc_box(&acc, "+");
+}
 
-    for (unsigned int i = 0; lval->count;)
-    {
-        lval_t *next = lval_pop(lval, 0);
+// Return the sum of the elements of a packed array.
+// e.g. `sum (pack {1 2 3})`
+lval_t *builtin_sum(lenv_t *env, lval_t **argv, size_t argc)
+{
+    larray_t *array = argv[0]->array;
+    int64_t sum;
 
-        while (next->count) {
-            join->cell[i] = lval_pop(next, 0);
-            i++;
-        }
+    if (array->kind == ARRAY_FLOAT)
+        return lval_float(lsimd_best()->sum_float(array->floats, array->count));
 
-        lval_del(next);
-    }
+    if (!lsimd_best()->sum_int(array->ints, array->count, &sum))
+        return lval_array_sum_big(array);
 
-    lval_del(lval);
-    return join;
+    return lval_num(sum);
 }
 
-lval_t *builtin_var(lenv_t *env, lval_t *lval, const char *function)
+// Return the smallest, or the biggest, element of a packed array.
+static lval_t *builtin_array_extremum(lval_t **argv, const char *function, bool biggest)
 {
-    LASSERT(lval, lval->cell[0]->type == QEXPR, "`def / =` function can only be applied to a Q-Expression of symbols followed by any expression");
-    LASSERT(lval, lval->cell[0]->count == lval->count - 1, "the number of variables must be the same as values when using the `de / =` function");
+    larray_t *array = argv[0]->array;
+    const lsimd_t *kernels = lsimd_best();
 
-    lval_t *symbols = lval->cell[0];
-
-    for (size_t i = 0; i < symbols->count; ++i)
-        LASSERT(symbols, symbols->cell[i]->type == SYMBOL, "all members of the q-expression after the `def / =` function must be symbols");
+    if (!array->count)
+        return lval_err("function '%s' expected a non-empty array", function);
 
-    for (size_t i = 0; i < symbols->count; ++i) {
-        if (strcmp(function, "def") == 0)
-            lenv_def(env, symbols->cell[i], lval->cell[i + 1]);
-        else if (strcmp(function, "=") == 0)
-            lenv_push(env, symbols->cell[i], lval->cell[i + 1]);
-    }
+    if (array->kind == ARRAY_FLOAT)
+        return lval_float(biggest ? kernels->max_float(array->floats, array->count) : kernels->min_float(array->floats, array->count));
 
-    lval_del(lval);
-    return lval_sexpr();
+    return lval_num(biggest ? kernels->max_int(array->ints, array->count) : kernels->min_int(array->ints, array->count));
 }
 
-lval_t *builtin_def(lenv_t *env, lval_t *lval)
+lval_t *builtin_smallest(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_var(env, lval, "def");
+    return builtin_array_extremum(argv, "smallest", false);
 }
 
-lval_t *builtin_push(lenv_t *env, lval_t *lval)
+lval_t *builtin_biggest(lenv_t *env, lval_t **argv, size_t argc)
 {
-    return builtin_var(env, lval, "=");
+    return builtin_array_extremum(argv, "biggest", true);
 }
 
-// Create a lambda function from two q-expr, one for the arguments,
-// and the other for the body.
-//
-// NOTE: you can create a function naming syntax using:
-//       `def {fun} (\ {args body} {def (head args) (\ (tail args) body)})`
-//       It defines a function that creates a lambda from `args` (the first
-//       one is the name of the function) and a `body`.
-//       e.g. `fun {add x y} {+ x y}`
-lval_t *builtin_lambda(lenv_t *env, lval_t *lval)
+/// @brief Get an operand of an elementwise builtin as a packed array.
+///        Integers are converted to floats if `kind` is ARRAY_FLOAT,
+///        and a number is repeated to match the length of the other operand.
+/// @param owned set to true if the returned array was allocated for the call.
+/// @return NULL if the operand is neither a number nor an array of `count` elements.
+static larray_t *larray_operand(lval_t *arg, larray_kind_t kind, size_t count, bool *owned)
 {
-    LASSERT_NUM_PARAMS("\\", lval, 2);
-    LASSERT_CHILDREN_TYPE("\\", lval, 0, QEXPR);
-    LASSERT_CHILDREN_TYPE("\\", lval, 1, QEXPR);
+    *owned = arg->type != ARRAY || arg->array->kind != kind;
 
-    for (size_t i = 0; i < lval->cell[0]->count ;++i)
-    {
-        // FIXME: this is wrong because on error lval wont be freed,
-        //        only lval->cell[0].
-        LASSERT_CHILDREN_TYPE("\\", lval->cell[0], i, SYMBOL);
-    }
+    if (arg->type == ARRAY && arg->array->count != count)
+        return NULL;
 
-    lval_t *formals = lval_pop(lval, 0);
-    lval_t *body = lval_pop(lval, 0);
-    lval_del(lval);
+    if (!*owned)
+        return arg->array;
 
-    return lval_lambda(env, formals, body);
-}
+    if (arg->type != ARRAY && arg->type != NUMBER && arg->type != FLOAT)
+        return NULL;
 
-lval_t *builtin_fn(lenv_t *env, lval_t *lval)
-{
-    LASSERT_NUM_PARAMS("fn", lval, 2);
-    LASSERT_CHILDREN_TYPE("fn", lval, 0, QEXPR);
-    LASSERT_CHILDREN_TYPE("fn", lval, 1, QEXPR);
+    larray_t *array = larray_new(kind, count);
 
-    for (size_t i = 0; i < lval->cell[0]->count ;++i)
+    for (size_t i = 0; i < count; ++i)
     {
-        // FIXME: this is wrong because on error lval wont be freed,
-        //        only lval->cell[1].
-        LASSERT_CHILDREN_TYPE("fn", lval->cell[0], i, SYMBOL);
+        if (arg->type == ARRAY)
+            array->floats[i] = (double)arg->array->ints[i];
+        else if (kind == ARRAY_INT)
+            array->ints[i] = arg->number;
+        else
+            array->floats[i] = arg->type == FLOAT ? arg->real : (double)arg->number;
     }
 
-    lval_t *formals = lval_pop(lval, 0);
-    lval_t *name = lval_pop(formals, 0);
-    lval_t *body = lval_pop(lval, 0);
-    lval_t *function = lval_lambda(env, formals, body);
-
-    lenv_def(env, name, function);
-    lval_del(lval);
-
-    return function;
+    return array;
 }
 
-lval_t *builtin_if(lenv_t *env, lval_t *lval)
+// Kind of the result of an elementwise operation on an array and another operand.
+static larray_kind_t larray_result_kind(const larray_t *array, const lval_t *other)
 {
-    LASSERT_NUM_PARAMS("if", lval, 3);
-    LASSERT_CHILDREN_TYPE("if", lval, 0, NUMBER);
-    LASSERT_CHILDREN_TYPE("if", lval, 1, QEXPR);
-    LASSERT_CHILDREN_TYPE("if", lval, 2, QEXPR);
+    if (array->kind == ARRAY_FLOAT || other->type == FLOAT)
+        return ARRAY_FLOAT;
 
-    lval_t *cond = lval_pop(lval, 0);
-    lval_t *expr = lval_take(lval, cond->number ? 0 : 1);
-    expr->type = SEXPR;
+    return other->type == ARRAY ? other->array->kind : ARRAY_INT;
+}
 
-    lval_del(cond);
+static lval_t *larray_operand_err(const char *function, const larray_t *array, const lval_t *other)
+{
+    if (other->type == ARRAY)
+        return lval_err("function '%s' expected arrays of the same length, got %ld and %ld", function, array->count, other->array->count);
 
-    return lval_eval(env, expr);
+    return lval_err("function '%s' expected a number or an array, not '%s'", function, lval_type_name(other->type));
 }
 
-lval_t *builtin_load(lenv_t *env, lval_t *lval)
+// Return the dot product of two packed arrays.
+// e.g. `dot (pack {1 2}) (pack {3 4})`
+lval_t *builtin_dot(lenv_t *env, lval_t **argv, size_t argc)
 {
-    LASSERT_NUM_PARAMS("load", lval, 1);
-    LASSERT_CHILDREN_TYPE("load", lval, 0, STRING);
+    larray_t *a = argv[0]->array;
+    larray_kind_t kind = larray_result_kind(a, argv[1]);
+    bool a_owned, b_owned;
+
+    if (a->count != argv[1]->array->count)
+        return larray_operand_err("dot", a, argv[1]);
+
+    a = larray_operand(argv[0], kind, a->count, &a_owned);
+    larray_t *b = larray_operand(argv[1], kind, a->count, &b_owned);
+    lval_t *result;
+    int64_t dot;
+
+    if (kind == ARRAY_FLOAT)
+        result = lval_float(lsimd_best()->dot_float(a->floats, b->floats, a->count));
+    else if (lsimd_best()->dot_int(a->ints, b->ints, a->count, &dot))
+        result = lval_num(dot);
+    else
+    {
+        lacc_t acc;
 
-    mpc_result_t r;
+        lacc_init(&acc, 0, NULL);
 
-    if (mpc_parse_contents(lval->cell[0]->string, env->parser->program, &r))
-    {
-        lval_t *expr = lval_read(r.output);
-        mpc_ast_delete(r.output);
+        for (size_t i = 0; i < a->count; ++i)
+        {
+            lacc_t term;
 
-        while (expr->count) {
-            lval_t *result = lval_eval(env, lval_pop(expr, 0));   
+            lacc_init(&term, a->ints[i], NULL);
+            lacc_apply(&term, "*", b->ints[i], NULL);
 
-            if (result->type == ERROR)
-              lval_println(result); 
+            lval_t *product = lacc_box(&term, "*");
 
-            lval_del(result);
+            lacc_apply(&acc, "+", product->number, product->type == NUMBER ? NULL : product);
+            lval_del(product);
         }
 
-        lval_del(expr);
-        lval_del(lval);
+        result = lacc_box(&acc, "+");
+    }
+
+    if (a_owned)
+        larray_del(a);
+    if (b_owned)
+        larray_del(b);
 
-        return lval_sexpr();
+    return result;
+}
+
+/// @brief Apply an arithmetic operator to each element of an array, and the element
+///        of a second array at the same index, or a number.
+/// @param op one of '+', '-' or '*'.
+static lval_t *builtin_array_op(lval_t **argv, const char *function, char op)
+{
+    const lsimd_t *kernels = lsimd_best();
+    size_t count = argv[0]->array->count;
+    larray_kind_t kind = larray_result_kind(argv[0]->array, argv[1]);
+    bool a_owned, b_owned;
+
+    larray_t *b = larray_operand(argv[1], kind, count, &b_owned);
+
+    if (!b)
+        return larray_operand_err(function, argv[0]->array, argv[1]);
+
+    larray_t *a = larray_operand(argv[0], kind, count, &a_owned);
+    larray_t *result = larray_new(kind, count);
+    bool overflow = false;
+
+    if (kind == ARRAY_FLOAT)
+    {
+        if (op == '+')
+            kernels->add_float(result->floats, a->floats, b->floats, count);
+        else if (op == '-')
+            kernels->sub_float(result->floats, a->floats, b->floats, count);
+        else
+            kernels->mul_float(result->floats, a->floats, b->floats, count);
     }
+    else if (op == '+')
+        overflow = !kernels->add_int(result->ints, a->ints, b->ints, count);
+    else if (op == '-')
+        overflow = !kernels->sub_int(result->ints, a->ints, b->ints, count);
     else
-    {
-        char *error_message = mpc_err_string(r.error);
-        lval_t *error = lval_err("failed to load file: %s", error_message);
+        overflow = !kernels->mul_int(result->ints, a->ints, b->ints, count);
 
-        mpc_err_delete(r.error);
-        free(error_message);
-        lval_del(lval);
+    if (a_owned)
+        larray_del(a);
+    if (b_owned)
+        larray_del(b);
 
-        return error;
+    // Packed integers cannot be promoted to bignums.
+    if (overflow) {
+        larray_del(result);
+        return lval_err("function '%s' overflowed, pack floats to compute on larger numbers", function);
     }
-}
 
-static void lval_print(const lval_t *);
+    return lval_array(result);
+}
 
-lval_t *builtin_print(lenv_t *env, lval_t *lval)
+lval_t *builtin_array_add(lenv_t *env, lval_t **argv, size_t argc)
 {
-    for (unsigned int i = 0; i < lval->count; ++i) {
-        lval_print(lval->cell[i]);
-        putchar(' ');
-    }
+    return builtin_array_op(argv, "add-each", '+');
+}
 
-    putchar('\n');
-    lval_del(lval);
+lval_t *builtin_array_sub(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_array_op(argv, "strain-each", '-');
+}
 
-    return lval_sexpr();
+lval_t *builtin_array_mul(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_array_op(argv, "mix-each", '*');
 }
 
-lval_t *builtin_error(lenv_t *env, lval_t *lval)
+// Compare each element of an array to the element of a second array at the same
+// index, or to a number, giving an array of 1 where the comparison holds and 0 elsewhere.
+static lval_t *builtin_array_cmp(lval_t **argv, const char *function, lsimd_cmp_t op)
 {
-    LASSERT_NUM_PARAMS("error", lval, 1);
-    LASSERT_CHILDREN_TYPE("error", lval, 0, STRING);
+    size_t count = argv[0]->array->count;
+    larray_kind_t kind = larray_result_kind(argv[0]->array, argv[1]);
+    bool a_owned, b_owned;
 
-    lval_t *error = lval_err(lval->cell[0]->string);
+    larray_t *b = larray_operand(argv[1], kind, count, &b_owned);
 
-    lval_del(lval);
+    if (!b)
+        return larray_operand_err(function, argv[0]->array, argv[1]);
+
+    larray_t *a = larray_operand(argv[0], kind, count, &a_owned);
+    larray_t *mask = larray_new(ARRAY_INT, count);
+
+    if (kind == ARRAY_FLOAT)
+        lsimd_best()->cmp_float(mask->ints, a->floats, b->floats, count, op);
+    else
+        lsimd_best()->cmp_int(mask->ints, a->ints, b->ints, count, op);
 
-    return error;
+    if (a_owned)
+        larray_del(a);
+    if (b_owned)
+        larray_del(b);
+
+    return lval_array(mask);
+}
+
+lval_t *builtin_array_eq(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_array_cmp(argv, "same-each", LSIMD_EQ);
+}
+
+lval_t *builtin_array_lt(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_array_cmp(argv, "smaller-each", LSIMD_LT);
+}
+
+lval_t *builtin_array_gt(lenv_t *env, lval_t **argv, size_t argc)
+{
+    return builtin_array_cmp(argv, "bigger-each", LSIMD_GT);
 }
 
 
@@ -861,6 +4099,36 @@ lval_t *builtin_error(lenv_t *env, lval_t *lval)
 //  -------------------------------
 
 static void lval_print_expr(const lval_t *lval, char begin, char end);
+static void lval_print_array(const larray_t *);
+static void lval_print_seq(const lseq_t *);
+static void lval_print_vector(const lvec_t *);
+static void lval_print_map(const lmap_t *);
+
+// Print the shortest form of a float that reads back to the same value.
+static void lval_print_float(double real)
+{
+    char buffer[32];
+    int precision = 1;
+
+    for (; precision < 17; ++precision)
+    {
+        snprintf(buffer, sizeof(buffer), "%.*g", precision, real);
+
+        if (strtod(buffer, NULL) == real)
+            break;
+    }
+
+    // Write all the integral digits instead of an exponent, e.g. `50.0` rather than `5e+01`.
+    if (fabs(real) >= 1 && fabs(real) < 1e16 && precision < (int)log10(fabs(real)) + 1)
+        precision = (int)log10(fabs(real)) + 1;
+
+    snprintf(buffer, sizeof(buffer), "%.*g", precision, real);
+    fputs(buffer, stdout);
+
+    // Keep floats apart from numbers.
+    if (isfinite(real) && !strpbrk(buffer, ".e"))
+        fputs(".0", stdout);
+}
 
 static void lval_print(const lval_t *lval)
 {
@@ -869,6 +4137,36 @@ static void lval_print(const lval_t *lval)
     case NUMBER:
         printf("%ld", lval->number);
         break;
+    case FLOAT:
+        lval_print_float(lval->real);
+        break;
+    case ARRAY:
+        lval_print_array(lval->array);
+        break;
+    case LAZY:
+        lval_print_seq(lval->seq);
+        break;
+    case VECTOR:
+        lval_print_vector(lval->vector);
+        break;
+    case MAP:
+        lval_print_map(lval->map);
+        break;
+    case TABLE:
+        printf("<hash table of %ld entries>", lval->table->count);
+        break;
+    case ROPE:
+        lval_print_string(lval);
+        break;
+    case BUILDER:
+        printf("<string builder of %ld bytes>", lval->builder->length);
+        break;
+    case BIGNUM: {
+        char *digits = lbig_to_string(lval->big);
+        fputs(digits, stdout);
+        free(digits);
+        break;
+    }
     case STRING:
         lval_print_string(lval);
         break;
@@ -885,13 +4183,21 @@ static void lval_print(const lval_t *lval)
         lval_print_expr(lval, '{', '}');
         break;
     case FUN:
-        if (lval->builtin) {
+        if (!lval->lambda) {
             puts("<builtin>");
         } else {
             printf("(\\");
-            lval_print(lval->formals);
+            lval_print(lval->lambda->formals);
             putchar(' ');
-            lval_print(lval->body);
+            lval_print(lval->lambda->body);
+
+            // Arguments of a partial application.
+            for (unsigned int i = 0; i < lval->count; ++i)
+            {
+                putchar(' ');
+                lval_print(lval->cell[i]);
+            }
+
             putchar(')');
         }
         break;
@@ -900,6 +4206,111 @@ static void lval_print(const lval_t *lval)
     }
 }
 
+static void lval_print_array(const larray_t *array)
+{
+    putchar('[');
+
+    for (size_t i = 0; i < array->count; ++i)
+    {
+        if (array->kind == ARRAY_INT)
+            printf("%ld", (long)array->ints[i]);
+        else
+            lval_print_float(array->floats[i]);
+
+        if (i != array->count - 1)
+        {
+            putchar(' ');
+        }
+    }
+
+    putchar(']');
+}
+
+// Print a lazy sequence without forcing it, as the expression
+// that computes its remaining elements.
+static void lval_print_seq(const lseq_t *seq)
+{
+    switch (seq->kind)
+    {
+    case LSEQ_RANGE:
+        printf("(range %ld %ld %ld)", seq->number, seq->end, seq->step);
+        return;
+    case LSEQ_ITERATE:
+        // Once started, the next element is the function applied to the last one.
+        fputs(seq->pending ? "(drop 1 (iterate " : "(iterate ", stdout);
+        lval_print(seq->fun);
+        putchar(' ');
+        lval_print(seq->value);
+        fputs(seq->pending ? "))" : ")", stdout);
+        return;
+    case LSEQ_LIST:
+        putchar('{');
+
+        for (size_t i = seq->number; i < seq->value->count; ++i)
+        {
+            lval_print(seq->value->cell[i]);
+
+            if (i != seq->value->count - 1)
+                putchar(' ');
+        }
+
+        putchar('}');
+        return;
+    case LSEQ_TAKE:
+    case LSEQ_DROP:
+        printf("(%s %ld ", seq->kind == LSEQ_TAKE ? "take" : "drop", seq->number);
+        break;
+    case LSEQ_MAP:
+    case LSEQ_FILTER:
+        fputs(seq->kind == LSEQ_MAP ? "(lazy-map " : "(lazy-filter ", stdout);
+        lval_print(seq->fun);
+        putchar(' ');
+        break;
+    }
+
+    lval_print_seq(seq->source);
+    putchar(')');
+}
+
+// Print a vector as the expression that builds it, e.g. `(vec {1 2 3})`.
+static void lval_print_vector(const lvec_t *vec)
+{
+    fputs("(vec {", stdout);
+
+    for (size_t i = 0; i < vec->count; ++i)
+    {
+        lval_print(lvec_nth(vec, i));
+
+        if (i != vec->count - 1)
+            putchar(' ');
+    }
+
+    fputs("})", stdout);
+}
+
+static void lval_print_entry(const lval_t *key, const lval_t *value, void *data)
+{
+    bool *first = data;
+
+    if (!*first)
+        putchar(' ');
+
+    lval_print(key);
+    putchar(' ');
+    lval_print(value);
+    *first = false;
+}
+
+// Print a map as the expression that builds it, e.g. `(dict {a 1 b 2})`.
+static void lval_print_map(const lmap_t *map)
+{
+    bool first = true;
+
+    fputs("(dict {", stdout);
+    lmap_each(map, &lval_print_entry, &first);
+    fputs("})", stdout);
+}
+
 static void lval_print_expr(const lval_t *lval, char begin, char end)
 {
     putchar(begin);
@@ -923,12 +4334,28 @@ void lval_println(lval_t *lval)
     putchar('\n');
 }
 
+// Print a string or a rope as a literal, with escape sequences for special characters.
 void lval_print_string(const lval_t *lval)
 {
-    char *escaped = strdup(lval->string);
-    escaped = mpcf_escape(escaped);
-    printf("\"%s\"", escaped);
-    free(escaped);
+    char *flat;
+    const char *text = lval_text_bytes(lval, &flat);
+    size_t length = lval_text_length(lval);
+
+    putchar('"');
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        const char *escape = memchr(lval_escapes, text[i], sizeof(lval_escapes));
+
+        if (escape) {
+            putchar('\\');
+            putchar(lval_escape_letters[escape - lval_escapes]);
+        } else
+            putchar(text[i]);
+    }
+
+    putchar('"');
+    free(flat);
 }
 
 
@@ -937,6 +4364,15 @@ char *lval_type_name(unsigned int t)
   switch (t)
   {
     case NUMBER: return "Number";
+    case BIGNUM: return "Bignum";
+    case FLOAT: return "Float";
+    case ARRAY: return "Array";
+    case LAZY: return "Lazy Sequence";
+    case VECTOR: return "Vector";
+    case MAP: return "Map";
+    case TABLE: return "Hash Table";
+    case ROPE: return "Rope";
+    case BUILDER: return "String Builder";
     case STRING: return "String";
     case FUN: return "Function";
     case ERROR: return "Error";
@@ -962,17 +4398,32 @@ lenv_t *lenv_clone(lenv_t *env)
     new->syms = malloc(sizeof(char *) * new->count);
     new->vals = malloc(sizeof(lval_t *) * new->count);
 
+    new->stamps = NULL;
+
     for (size_t i = 0; i < new->count; ++i)
     {
         new->syms[i] = strdup(env->syms[i]);
         new->vals[i] = lval_clone(env->vals[i]);
     }
 
+    if (env->stamps)
+    {
+        new->stamps = malloc(sizeof(size_t) * new->count);
+        memcpy(new->stamps, env->stamps, sizeof(size_t) * new->count);
+    }
+
     return new;
 }
 
 lval_t *lval_clone(lval_t *lval)
 {
+    if (lval_is_immortal(lval))
+        return lval;
+
+    // Q-expressions are data, clones share their cells until one of them is modified.
+    if (lval->type == QEXPR)
+        return lval_view(lval, 0, lval->count);
+
     lval_t *new = malloc(sizeof(lval_t));
 
     if (!new) return NULL;
@@ -981,13 +4432,24 @@ lval_t *lval_clone(lval_t *lval)
 
     switch (new->type) {
         case NUMBER: new->number = lval->number; break;
-        case STRING: new->string = strdup(lval->string); break;
-        case SYMBOL: new->symbol = strdup(lval->symbol); break;
+        case BIGNUM: new->big = lbig_clone(lval->big); break;
+        case FLOAT: new->real = lval->real; break;
+        case ARRAY: new->array = larray_clone(lval->array); break;
+        case LAZY: new->seq = lseq_clone(lval->seq); break;
+        case VECTOR: new->vector = lvec_clone(lval->vector); break;
+        case MAP: new->map = lmap_clone(lval->map); break;
+        case TABLE: new->table = ltable_ref(lval->table); break;
+        case ROPE: new->rope = lrope_ref(lval->rope); break;
+        case BUILDER: new->builder = lbuilder_ref(lval->builder); break;
+        case STRING: new->string = lstr_ref(lval->string); break;
+        case SYMBOL: lval_set_symbol(new, lval->symbol); break;
         case ERROR: new->error = strdup(lval->error); break;
         case SEXPR:
-        case QEXPR:
+            new->count = 0;
+            new->cell = NULL;
+            new->shared = NULL;
+            lval_resize_cells(new, lval->count);
             new->count = lval->count;
-            new->cell = malloc(sizeof(lval_t *) * new->count);
 
             for (unsigned int i = 0; i < new->count; ++i)
             {
@@ -995,14 +4457,28 @@ lval_t *lval_clone(lval_t *lval)
             }
             break;
         case FUN:
-            if (lval->builtin)
+            new->shared = NULL;
+
+            if (!lval->lambda)
             {
                 new->builtin = lval->builtin;
+                new->native = lval->native;
+                new->lambda = NULL;
+                new->count = 0;
+                new->cell = NULL;
             } else {
                 new->builtin = NULL;
-                new->env = lenv_clone(lval->env);
-                new->formals = lval_clone(lval->formals);
-                new->body = lval_clone(lval->body);
+                new->native = NULL;
+                new->lambda = llambda_ref(lval->lambda);
+                new->count = 0;
+                new->cell = NULL;
+                lval_resize_cells(new, lval->count);
+                new->count = lval->count;
+
+                for (unsigned int i = 0; i < new->count; ++i)
+                {
+                    new->cell[i] = lval_clone(lval->cell[i]);
+                }
             }
             break;
         default:
@@ -1024,36 +4500,99 @@ void lenv_del(lenv_t *env)
 
     free(env->syms);
     free(env->vals);
+    free(env->stamps);
     free(env);
 }
 
+// Share the code of a lambda with a new clone.
+llambda_t *llambda_ref(llambda_t *lambda)
+{
+    lambda->refs++;
+    return lambda;
+}
+
+// Release the code of a lambda, freeing it when its last clone is gone.
+void llambda_unref(llambda_t *lambda)
+{
+    if (--lambda->refs)
+        return;
+
+    lval_del(lambda->formals);
+    lval_del(lambda->body);
+    lmemo_del(lambda->memo);
+
+    if (lambda->inlined)
+        lval_del(lambda->inlined);
+
+    ldeps_clear(&lambda->deps);
+    free(lambda);
+}
+
 // Clean up a lval and all of it's nodes.
 void lval_del(lval_t *lval)
 {
+    if (lval_is_immortal(lval))
+        return;
+
     switch (lval->type)
     {
     case NUMBER:
+    case FLOAT:
+        break;
+    case BIGNUM:
+        lbig_del(lval->big);
+        break;
+    case ARRAY:
+        larray_del(lval->array);
+        break;
+    case LAZY:
+        lseq_del(lval->seq);
+        break;
+    case VECTOR:
+        lvec_del(lval->vector);
+        break;
+    case MAP:
+        lmap_del(lval->map);
+        break;
+    case TABLE:
+        ltable_unref(lval->table);
+        break;
+    case ROPE:
+        lrope_unref(lval->rope);
+        break;
+    case BUILDER:
+        lbuilder_unref(lval->builder);
         break;
     case STRING:
-        free(lval->string);
+        lstr_unref(lval->string);
         break;
     case SYMBOL:
-        free(lval->symbol);
+        if (lval->symbol != lval->inline_symbol)
+            free(lval->symbol);
         break;
     case SEXPR:
     case QEXPR:
+        if (lval->shared) {
+            lcells_unref(lval->shared);
+            break;
+        }
+
         for (unsigned int i = 0; i < lval->count; ++i)
         {
             lval_del(lval->cell[i]);
         }
-        free(lval->cell);
+        lval_free_cells(lval);
         break;
     case FUN:
-        if (!lval->builtin)
+        if (lval->lambda)
         {
-            lenv_del(lval->env);
-            lval_del(lval->formals);
-            lval_del(lval->body);
+            llambda_unref(lval->lambda);
+
+            for (unsigned int i = 0; i < lval->count; ++i)
+            {
+                lval_del(lval->cell[i]);
+            }
+            lval_free_cells(lval);
         }
         break;
     default:
@@ -53,6 +53,12 @@ int main(int argc, char **argv)
 	else
 	{
 		for (unsigned int i = 1; i < argc; ++i) {
+			// Applies to the scripts given after it.
+			if (strcmp(argv[i], "--no-intern") == 0) {
+				lval_intern_literals = false;
+				continue;
+			}
+
 			lval_t *script_path = lval_add(lval_sexpr(), lval_string(argv[i]));
 			lval_t *result = builtin_load(env, script_path);
 
@@ -65,6 +71,7 @@ int main(int argc, char **argv)
 
 	cleanup_parser(&parser);
 	lenv_del(env);
+	lval_literals_del();
 
 	return OK;
 }
\ No newline at end of file
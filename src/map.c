@@ -0,0 +1,358 @@
+#include "map.h"
+
+//  -------
+// | Nodes |
+//  -------
+
+static lmap_node_t *lmap_node_new(void)
+{
+    lmap_node_t *node = malloc(sizeof(lmap_node_t));
+
+    node->refs = 1;
+    node->bitmap = 0;
+    node->count = 0;
+    node->entries = NULL;
+
+    return node;
+}
+
+static lmap_node_t *lmap_node_ref(lmap_node_t *node)
+{
+    if (node)
+        ++node->refs;
+
+    return node;
+}
+
+// Release a node, freeing it along with its entries once nothing refers to it.
+static void lmap_node_unref(lmap_node_t *node)
+{
+    if (!node || --node->refs)
+        return;
+
+    for (size_t i = 0; i < node->count; ++i)
+    {
+        lmap_entry_t *entry = &node->entries[i];
+
+        if (entry->key) {
+            lval_del(entry->key);
+            lval_del(entry->value);
+        } else
+            lmap_node_unref(entry->node);
+    }
+
+    free(node->entries);
+    free(node);
+}
+
+// Get a node that can be modified in place: the node itself if nothing else
+// refers to it, a copy otherwise. Creates the node if it is NULL.
+static lmap_node_t *lmap_node_edit(lmap_node_t *node)
+{
+    if (!node)
+        return lmap_node_new();
+
+    if (node->refs == 1)
+        return node;
+
+    lmap_node_t *copy = lmap_node_new();
+
+    copy->bitmap = node->bitmap;
+    copy->count = node->count;
+    copy->entries = malloc(sizeof(lmap_entry_t) * node->count);
+
+    for (size_t i = 0; i < node->count; ++i)
+    {
+        lmap_entry_t *entry = &node->entries[i];
+
+        copy->entries[i].hash = entry->hash;
+        copy->entries[i].key = entry->key ? lval_clone(entry->key) : NULL;
+        copy->entries[i].value = entry->key ? lval_clone(entry->value) : NULL;
+        copy->entries[i].node = lmap_node_ref(entry->node);
+    }
+
+    --node->refs;
+
+    return copy;
+}
+
+// Make room for an entry at an index, the entry is left uninitialized.
+static lmap_entry_t *lmap_node_insert(lmap_node_t *node, size_t index)
+{
+    node->entries = realloc(node->entries, sizeof(lmap_entry_t) * (node->count + 1));
+    memmove(&node->entries[index + 1], &node->entries[index], sizeof(lmap_entry_t) * (node->count - index));
+    ++node->count;
+
+    return &node->entries[index];
+}
+
+// Remove the entry at an index, without freeing what it holds.
+static void lmap_node_remove(lmap_node_t *node, size_t index)
+{
+    --node->count;
+    memmove(&node->entries[index], &node->entries[index + 1], sizeof(lmap_entry_t) * (node->count - index));
+}
+
+// Bit of the bitmap of a node at a given level for a hash.
+static uint32_t lmap_bit(size_t hash, unsigned int shift)
+{
+    return (uint32_t)1 << ((hash >> shift) & LMAP_MASK);
+}
+
+// Index of the entry of a bit among the entries of a node.
+static size_t lmap_index(const lmap_node_t *node, uint32_t bit)
+{
+    return __builtin_popcount(node->bitmap & (bit - 1));
+}
+
+//  --------------
+// | Constructors |
+//  --------------
+
+lmap_t *lmap_new(void)
+{
+    lmap_t *map = malloc(sizeof(lmap_t));
+
+    map->count = 0;
+    map->root = NULL;
+
+    return map;
+}
+
+// Clones share all their nodes, in O(1).
+lmap_t *lmap_clone(const lmap_t *map)
+{
+    lmap_t *new = malloc(sizeof(lmap_t));
+
+    new->count = map->count;
+    new->root = lmap_node_ref(map->root);
+
+    return new;
+}
+
+void lmap_del(lmap_t *map)
+{
+    lmap_node_unref(map->root);
+    free(map);
+}
+
+//  --------
+// | Lookup |
+//  --------
+
+/// @brief Get the value associated to a key, in O(log32 n).
+/// @return the value, still owned by the map, or NULL if the key is missing.
+lval_t *lmap_get(const lmap_t *map, const lval_t *key)
+{
+    size_t hash = lval_hash(key);
+    const lmap_node_t *node = map->root;
+
+    for (unsigned int shift = 0; node; shift += LMAP_BITS)
+    {
+        if (shift >= LMAP_HASH_BITS)
+        {
+            for (size_t i = 0; i < node->count; ++i) {
+                if (lval_eq(node->entries[i].key, (lval_t *)key))
+                    return node->entries[i].value;
+            }
+
+            return NULL;
+        }
+
+        uint32_t bit = lmap_bit(hash, shift);
+
+        if (!(node->bitmap & bit))
+            return NULL;
+
+        const lmap_entry_t *entry = &node->entries[lmap_index(node, bit)];
+
+        if (entry->key)
+            return entry->hash == hash && lval_eq(entry->key, (lval_t *)key) ? entry->value : NULL;
+
+        node = entry->node;
+    }
+
+    return NULL;
+}
+
+// Call a function on every key and value of a map, in no particular order.
+static void lmap_node_each(const lmap_node_t *node, lmap_visit_t visit, void *data)
+{
+    for (size_t i = 0; node && i < node->count; ++i)
+    {
+        const lmap_entry_t *entry = &node->entries[i];
+
+        if (entry->key)
+            visit(entry->key, entry->value, data);
+        else
+            lmap_node_each(entry->node, visit, data);
+    }
+}
+
+void lmap_each(const lmap_t *map, lmap_visit_t visit, void *data)
+{
+    lmap_node_each(map->root, visit, data);
+}
+
+//  ---------------
+// | Modifications |
+//  ---------------
+
+static lmap_node_t *lmap_node_assoc(lmap_node_t *node, unsigned int shift, size_t hash,
+                                    lval_t *key, lval_t *value, bool *added)
+{
+    node = lmap_node_edit(node);
+
+    if (shift >= LMAP_HASH_BITS)
+    {
+        for (size_t i = 0; i < node->count; ++i)
+        {
+            if (lval_eq(node->entries[i].key, key)) {
+                lval_del(key);
+                lval_del(node->entries[i].value);
+                node->entries[i].value = value;
+                return node;
+            }
+        }
+
+        *lmap_node_insert(node, node->count) = (lmap_entry_t){hash, key, value, NULL};
+        *added = true;
+        return node;
+    }
+
+    uint32_t bit = lmap_bit(hash, shift);
+    size_t index = lmap_index(node, bit);
+
+    if (!(node->bitmap & bit))
+    {
+        *lmap_node_insert(node, index) = (lmap_entry_t){hash, key, value, NULL};
+        node->bitmap |= bit;
+        *added = true;
+        return node;
+    }
+
+    lmap_entry_t *entry = &node->entries[index];
+
+    if (!entry->key)
+        entry->node = lmap_node_assoc(entry->node, shift + LMAP_BITS, hash, key, value, added);
+    else if (entry->hash == hash && lval_eq(entry->key, key))
+    {
+        lval_del(key);
+        lval_del(entry->value);
+        entry->value = value;
+    }
+    else
+    {
+        // Two keys share these bits of their hashes, they move to a node of the next level.
+        bool moved = false;
+        lmap_node_t *child = lmap_node_assoc(NULL, shift + LMAP_BITS, entry->hash, entry->key, entry->value, &moved);
+
+        entry->node = lmap_node_assoc(child, shift + LMAP_BITS, hash, key, value, added);
+        entry->key = NULL;
+        entry->value = NULL;
+    }
+
+    return node;
+}
+
+/// @brief Associate a value to a key, replacing its previous value if any.
+///        Only the nodes shared with other maps are copied.
+///        Takes ownership of the key and the value.
+void lmap_assoc(lmap_t *map, lval_t *key, lval_t *value)
+{
+    bool added = false;
+
+    map->root = lmap_node_assoc(map->root, 0, lval_hash(key), key, value, &added);
+
+    if (added)
+        ++map->count;
+}
+
+// Remove a key known to be in the trie under `node`.
+// Return the node, or NULL once it has no entries left.
+static lmap_node_t *lmap_node_dissoc(lmap_node_t *node, unsigned int shift, size_t hash, const lval_t *key)
+{
+    node = lmap_node_edit(node);
+
+    size_t index = 0;
+
+    if (shift >= LMAP_HASH_BITS)
+    {
+        while (!lval_eq(node->entries[index].key, (lval_t *)key))
+            ++index;
+    }
+    else
+    {
+        uint32_t bit = lmap_bit(hash, shift);
+        lmap_entry_t *entry = &node->entries[index = lmap_index(node, bit)];
+
+        if (!entry->key)
+        {
+            entry->node = lmap_node_dissoc(entry->node, shift + LMAP_BITS, hash, key);
+
+            if (entry->node)
+                return node;
+        }
+
+        node->bitmap &= ~bit;
+    }
+
+    if (node->entries[index].key) {
+        lval_del(node->entries[index].key);
+        lval_del(node->entries[index].value);
+    }
+
+    lmap_node_remove(node, index);
+
+    if (!node->count) {
+        free(node->entries);
+        free(node);
+        return NULL;
+    }
+
+    return node;
+}
+
+/// @brief Remove a key from a map, if it is in it.
+///        Only the nodes shared with other maps are copied.
+void lmap_dissoc(lmap_t *map, const lval_t *key)
+{
+    if (!lmap_get(map, key))
+        return;
+
+    map->root = lmap_node_dissoc(map->root, 0, lval_hash(key), key);
+    --map->count;
+}
+
+//  ------------
+// | Comparison |
+//  ------------
+
+static void lmap_eq_visit(const lval_t *key, const lval_t *value, void *data)
+{
+    const lmap_t **maps = data;
+
+    if (!maps[0])
+        return;
+
+    const lval_t *other = lmap_get(maps[0], key);
+
+    if (!other || !lval_eq((lval_t *)value, (lval_t *)other))
+        maps[0] = NULL;
+}
+
+bool lmap_eq(const lmap_t *x, const lmap_t *y)
+{
+    if (x->count != y->count)
+        return false;
+
+    if (x->root == y->root)
+        return true;
+
+    // Cleared by the visitor at the first key of `x` missing or different in `y`.
+    const lmap_t *maps[1] = {y};
+
+    lmap_each(x, &lmap_eq_visit, maps);
+
+    return maps[0] != NULL;
+}
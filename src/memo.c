@@ -0,0 +1,180 @@
+#include "memo.h"
+
+//  --------------
+// | Constructors |
+//  --------------
+
+// Return a new, empty cache able to hold `capacity` results.
+lmemo_t *lmemo_new(size_t capacity)
+{
+    lmemo_t *memo = malloc(sizeof(lmemo_t));
+
+    if (!memo)
+        return NULL;
+
+    memo->capacity = capacity ? capacity : 1;
+    memo->count = 0;
+    memo->head = NULL;
+    memo->tail = NULL;
+    memo->hits = 0;
+    memo->misses = 0;
+    memo->effect = EFFECTFUL;
+    memo->deps = (ldeps_t){0};
+
+    // Keep the load factor under one, the cache never grows past its capacity.
+    for (memo->bucket_count = 16; memo->bucket_count < memo->capacity; memo->bucket_count <<= 1);
+    memo->buckets = calloc(memo->bucket_count, sizeof(lmemo_entry_t *));
+
+    return memo;
+}
+
+// Free a cache and all of its results.
+void lmemo_del(lmemo_t *memo)
+{
+    if (!memo)
+        return;
+
+    lmemo_clear(memo);
+    ldeps_clear(&memo->deps);
+    free(memo->buckets);
+    free(memo);
+}
+
+//  ------------------
+// | Recency tracking |
+//  ------------------
+
+static void lmemo_unlink(lmemo_t *memo, lmemo_entry_t *entry)
+{
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        memo->head = entry->next;
+
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        memo->tail = entry->prev;
+}
+
+static void lmemo_push_front(lmemo_t *memo, lmemo_entry_t *entry)
+{
+    entry->prev = NULL;
+    entry->next = memo->head;
+
+    if (memo->head)
+        memo->head->prev = entry;
+    else
+        memo->tail = entry;
+
+    memo->head = entry;
+}
+
+static lmemo_entry_t **lmemo_bucket(lmemo_t *memo, size_t hash)
+{
+    return &memo->buckets[hash & (memo->bucket_count - 1)];
+}
+
+// Remove and free the least recently used entry.
+static void lmemo_evict(lmemo_t *memo)
+{
+    lmemo_entry_t *victim = memo->tail;
+    lmemo_entry_t **link = lmemo_bucket(memo, victim->hash);
+
+    for (; *link != victim; link = &(*link)->chain);
+    *link = victim->chain;
+
+    lmemo_unlink(memo, victim);
+    lval_del(victim->args);
+    lval_del(victim->result);
+    free(victim);
+    memo->count--;
+}
+
+//  --------
+// | Lookup |
+//  --------
+
+/// @brief Look for the result of a previous call made with the same arguments.
+/// @param memo cache of the called recipe.
+/// @param args evaluated arguments of the call.
+/// @return the cached result, still owned by the cache, or NULL on a miss.
+lval_t *lmemo_get(lmemo_t *memo, lval_t *args)
+{
+    size_t hash = lval_hash(args);
+
+    for (lmemo_entry_t *entry = *lmemo_bucket(memo, hash); entry; entry = entry->chain)
+    {
+        if (entry->hash == hash && lval_eq(entry->args, args))
+        {
+            memo->hits++;
+
+            if (entry != memo->head)
+            {
+                lmemo_unlink(memo, entry);
+                lmemo_push_front(memo, entry);
+            }
+
+            return entry->result;
+        }
+    }
+
+    memo->misses++;
+    return NULL;
+}
+
+/// @brief Store the result of a call, evicting the least recently used one if full.
+/// @param memo cache of the called recipe.
+/// @param args arguments of the call, owned by the cache afterwards.
+/// @param result value returned by the call, owned by the cache afterwards.
+void lmemo_put(lmemo_t *memo, lval_t *args, lval_t *result)
+{
+    lmemo_entry_t *entry = malloc(sizeof(lmemo_entry_t));
+
+    if (memo->count == memo->capacity)
+        lmemo_evict(memo);
+
+    entry->hash = lval_hash(args);
+    entry->args = args;
+    entry->result = result;
+
+    lmemo_entry_t **bucket = lmemo_bucket(memo, entry->hash);
+    entry->chain = *bucket;
+    *bucket = entry;
+
+    lmemo_push_front(memo, entry);
+    memo->count++;
+}
+
+// Drop every cached result and reset the statistics.
+void lmemo_clear(lmemo_t *memo)
+{
+    while (memo->tail)
+        lmemo_evict(memo);
+
+    memo->hits = 0;
+    memo->misses = 0;
+}
+
+/// @brief Bring a cache up to date with the global environment before a call.
+///        Results are dropped once a name the recipe looks up, directly or
+///        through the recipes it calls, has been rebound.
+/// @param memo cache of the called recipe.
+/// @param env environment the recipe is called from.
+/// @param fun the called recipe.
+/// @return false if the recipe has side effects or reads mutable state, or if
+///         the caller binds a name it looks up, and must not be served from the cache.
+bool lmemo_sync(lmemo_t *memo, lenv_t *env, lval_t *fun)
+{
+    if (ldeps_stale(&memo->deps, env))
+    {
+        while (memo->tail)
+            lmemo_evict(memo);
+
+        ldeps_clear(&memo->deps);
+        memo->effect = lval_effect(env, fun, &memo->deps);
+        memo->deps.generation = lenv_generation;
+    }
+
+    return memo->effect < READS_STATE && !ldeps_shadowed(&memo->deps, env);
+}
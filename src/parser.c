@@ -2,6 +2,7 @@
 
 sep_t init_parser()
 {
+  mpc_parser_t *floating = mpc_new("float");
   mpc_parser_t *number = mpc_new("number");
   mpc_parser_t *string = mpc_new("string");
   mpc_parser_t *symbol = mpc_new("symbol");
@@ -12,6 +13,7 @@ sep_t init_parser()
   mpc_parser_t *program = mpc_new("dlisp");
 
   sep_t parser = {
+      .floating = floating,
       .number = number,
       .string = string,
       .symbol = symbol,
@@ -23,16 +25,18 @@ sep_t init_parser()
 
   mpca_lang(MPCA_LANG_DEFAULT,
             "                                           \
+float   : /-?[0-9]+\\.[0-9]+([eE][-+]?[0-9]+)?/ ;       \
 number  : /-?[0-9]+/ ;                                  \
 string  : /\"(\\\\.|[^\"])*\"/ ;                        \
-symbol  : /[a-zA-Z0-9_+\\-*\\/\\\\=<>!&]+/ ;            \
+symbol  : /[a-zA-Z0-9_+\\-*\\/\\\\=<>!&?]+/ ;           \
 comment : /;[^\\r\\n]*/ ;                               \
 sexpr   : '(' <expr>* ')' ;                             \
 qexpr   : '{' <expr>* '}' ;                             \
-expr    : <number> | <string> | <symbol> | <comment>    \
-        | <sexpr> | <qexpr> ;                           \
+expr    : <float> | <number> | <string> | <symbol>      \
+        | <comment> | <sexpr> | <qexpr> ;               \
 dlisp   : /^/ <expr>* /$/ ;                             \
 ",
+            floating,
             number,
             string,
             symbol,
@@ -47,7 +51,8 @@ dlisp   : /^/ <expr>* /$/ ;                             \
 
 void cleanup_parser(sep_t *parser)
 {
-  mpc_cleanup(8,
+  mpc_cleanup(9,
+              parser->floating,
               parser->number,
               parser->string,
               parser->symbol,
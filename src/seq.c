@@ -0,0 +1,226 @@
+#include "seq.h"
+
+//  --------------
+// | Constructors |
+//  --------------
+
+static lseq_t *lseq_new(lseq_kind_t kind)
+{
+    lseq_t *seq = malloc(sizeof(lseq_t));
+
+    seq->kind = kind;
+    seq->number = 0;
+    seq->end = 0;
+    seq->step = 0;
+    seq->value = NULL;
+    seq->pending = false;
+    seq->fun = NULL;
+    seq->source = NULL;
+
+    return seq;
+}
+
+// Numbers from `start` up to, excluding, `end`, separated by a non-zero `step`.
+lseq_t *lseq_range(long start, long end, long step)
+{
+    lseq_t *seq = lseq_new(LSEQ_RANGE);
+
+    seq->number = start;
+    seq->end = end;
+    seq->step = step;
+
+    return seq;
+}
+
+// `value`, then `fun` applied to it, then to that result, and so on.
+// Takes ownership of both.
+lseq_t *lseq_iterate(lval_t *fun, lval_t *value)
+{
+    lseq_t *seq = lseq_new(LSEQ_ITERATE);
+
+    seq->fun = fun;
+    seq->value = value;
+
+    return seq;
+}
+
+// Elements of a q-expression. Takes ownership of it.
+lseq_t *lseq_list(lval_t *list)
+{
+    lseq_t *seq = lseq_new(LSEQ_LIST);
+
+    seq->value = list;
+
+    return seq;
+}
+
+/// @brief Transform a sequence with `take`, `drop`, `lazy-map` or `lazy-filter`.
+///        Takes ownership of the source and the function.
+/// @param number count of elements to take or to drop.
+/// @param fun function to map or to filter with, NULL for `take` and `drop`.
+lseq_t *lseq_wrap(lseq_kind_t kind, lseq_t *source, long number, lval_t *fun)
+{
+    lseq_t *seq = lseq_new(kind);
+
+    seq->source = source;
+    seq->number = number;
+    seq->fun = fun;
+
+    return seq;
+}
+
+lseq_t *lseq_clone(const lseq_t *seq)
+{
+    lseq_t *clone = lseq_new(seq->kind);
+
+    clone->number = seq->number;
+    clone->end = seq->end;
+    clone->step = seq->step;
+    clone->value = seq->value ? lval_clone(seq->value) : NULL;
+    clone->pending = seq->pending;
+    clone->fun = seq->fun ? lval_clone(seq->fun) : NULL;
+    clone->source = seq->source ? lseq_clone(seq->source) : NULL;
+
+    return clone;
+}
+
+void lseq_del(lseq_t *seq)
+{
+    if (seq->value)
+        lval_del(seq->value);
+    if (seq->fun)
+        lval_del(seq->fun);
+    if (seq->source)
+        lseq_del(seq->source);
+
+    free(seq);
+}
+
+//  -----------
+// | Iteration |
+//  -----------
+
+// Check if a sequence has a finite number of elements, so it can be forced.
+// Filtering an unbounded sequence is never bounded, even if it stops matching.
+bool lseq_bounded(const lseq_t *seq)
+{
+    switch (seq->kind) {
+        case LSEQ_RANGE:
+        case LSEQ_LIST:
+        case LSEQ_TAKE:
+            return true;
+        case LSEQ_ITERATE:
+            return false;
+        default:
+            return lseq_bounded(seq->source);
+    }
+}
+
+/// @brief Compute the next element of a sequence, advancing it.
+/// @param env environment functions of the sequence are called from.
+/// @return the element, NULL once the sequence is exhausted, or an error.
+lval_t *lseq_next(lenv_t *env, lseq_t *seq)
+{
+    switch (seq->kind) {
+        case LSEQ_RANGE:
+        {
+            if (seq->step > 0 ? seq->number >= seq->end : seq->number <= seq->end)
+                return NULL;
+
+            long number = seq->number;
+
+            // A range reaching the limits of a `long` ends there.
+            if (__builtin_add_overflow(seq->number, seq->step, &seq->number))
+                seq->number = seq->end;
+
+            return lval_num(number);
+        }
+        case LSEQ_ITERATE:
+        {
+            if (seq->pending)
+            {
+                lval_t *arg = lval_clone(seq->value);
+                lval_t *next = lval_call_argv(env, seq->fun, &arg, 1);
+
+                if (next->type == ERROR)
+                    return next;
+
+                lval_del(seq->value);
+                seq->value = next;
+            }
+
+            seq->pending = true;
+
+            return lval_clone(seq->value);
+        }
+        case LSEQ_LIST:
+            if ((size_t)seq->number >= seq->value->count)
+                return NULL;
+
+            return lval_clone(seq->value->cell[seq->number++]);
+        case LSEQ_TAKE:
+            if (seq->number <= 0)
+                return NULL;
+
+            seq->number--;
+
+            return lseq_next(env, seq->source);
+        case LSEQ_DROP:
+            for (; seq->number > 0; --seq->number)
+            {
+                lval_t *skipped = lseq_next(env, seq->source);
+
+                if (!skipped || skipped->type == ERROR)
+                    return skipped;
+
+                lval_del(skipped);
+            }
+
+            return lseq_next(env, seq->source);
+        case LSEQ_MAP:
+        {
+            lval_t *element = lseq_next(env, seq->source);
+
+            if (!element || element->type == ERROR)
+                return element;
+
+            return lval_call_argv(env, seq->fun, &element, 1);
+        }
+        case LSEQ_FILTER:
+            for (;;)
+            {
+                lval_t *element = lseq_next(env, seq->source);
+
+                if (!element || element->type == ERROR)
+                    return element;
+
+                lval_t *arg = lval_clone(element);
+                lval_t *keep = lval_call_argv(env, seq->fun, &arg, 1);
+
+                if (keep->type != NUMBER)
+                {
+                    lval_del(element);
+
+                    if (keep->type == ERROR)
+                        return keep;
+
+                    lval_t *err = lval_err("function 'lazy-filter' expected its predicate to return a number, not '%s'",
+                                           lval_type_name(keep->type));
+
+                    lval_del(keep);
+                    return err;
+                }
+
+                bool kept = keep->number;
+
+                lval_del(keep);
+
+                if (kept)
+                    return element;
+
+                lval_del(element);
+            }
+    }
+
+    return NULL;
+}
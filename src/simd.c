@@ -0,0 +1,762 @@
+#include "simd.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+//  --------
+// | Scalar |
+//  --------
+
+static bool scalar_sum_int(const int64_t *a, size_t n, int64_t *out)
+{
+    int64_t sum = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (__builtin_add_overflow(sum, a[i], &sum))
+            return false;
+    }
+
+    *out = sum;
+    return true;
+}
+
+static double scalar_sum_float(const double *a, size_t n)
+{
+    double sum = 0;
+
+    for (size_t i = 0; i < n; ++i)
+        sum += a[i];
+
+    return sum;
+}
+
+static int64_t scalar_min_int(const int64_t *a, size_t n)
+{
+    int64_t min = a[0];
+
+    for (size_t i = 1; i < n; ++i)
+        min = a[i] < min ? a[i] : min;
+
+    return min;
+}
+
+static int64_t scalar_max_int(const int64_t *a, size_t n)
+{
+    int64_t max = a[0];
+
+    for (size_t i = 1; i < n; ++i)
+        max = a[i] > max ? a[i] : max;
+
+    return max;
+}
+
+static double scalar_min_float(const double *a, size_t n)
+{
+    double min = a[0];
+
+    for (size_t i = 1; i < n; ++i)
+        min = a[i] < min ? a[i] : min;
+
+    return min;
+}
+
+static double scalar_max_float(const double *a, size_t n)
+{
+    double max = a[0];
+
+    for (size_t i = 1; i < n; ++i)
+        max = a[i] > max ? a[i] : max;
+
+    return max;
+}
+
+static bool scalar_dot_int(const int64_t *a, const int64_t *b, size_t n, int64_t *out)
+{
+    int64_t sum = 0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        int64_t product;
+
+        if (__builtin_mul_overflow(a[i], b[i], &product) || __builtin_add_overflow(sum, product, &sum))
+            return false;
+    }
+
+    *out = sum;
+    return true;
+}
+
+static double scalar_dot_float(const double *a, const double *b, size_t n)
+{
+    double sum = 0;
+
+    for (size_t i = 0; i < n; ++i)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+static bool scalar_add_int(int64_t *r, const int64_t *a, const int64_t *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (__builtin_add_overflow(a[i], b[i], &r[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static bool scalar_sub_int(int64_t *r, const int64_t *a, const int64_t *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (__builtin_sub_overflow(a[i], b[i], &r[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static bool scalar_mul_int(int64_t *r, const int64_t *a, const int64_t *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (__builtin_mul_overflow(a[i], b[i], &r[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static void scalar_add_float(double *r, const double *a, const double *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        r[i] = a[i] + b[i];
+}
+
+static void scalar_sub_float(double *r, const double *a, const double *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        r[i] = a[i] - b[i];
+}
+
+static void scalar_mul_float(double *r, const double *a, const double *b, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        r[i] = a[i] * b[i];
+}
+
+static void scalar_cmp_int(int64_t *r, const int64_t *a, const int64_t *b, size_t n, lsimd_cmp_t op)
+{
+    for (size_t i = 0; i < n; ++i)
+        r[i] = op == LSIMD_EQ ? a[i] == b[i] : op == LSIMD_LT ? a[i] < b[i] : a[i] > b[i];
+}
+
+static void scalar_cmp_float(int64_t *r, const double *a, const double *b, size_t n, lsimd_cmp_t op)
+{
+    for (size_t i = 0; i < n; ++i)
+        r[i] = op == LSIMD_EQ ? a[i] == b[i] : op == LSIMD_LT ? a[i] < b[i] : a[i] > b[i];
+}
+
+const lsimd_t lsimd_scalar = {
+    .name = "scalar",
+    .sum_int = &scalar_sum_int,
+    .sum_float = &scalar_sum_float,
+    .min_int = &scalar_min_int,
+    .max_int = &scalar_max_int,
+    .min_float = &scalar_min_float,
+    .max_float = &scalar_max_float,
+    .dot_int = &scalar_dot_int,
+    .dot_float = &scalar_dot_float,
+    .add_int = &scalar_add_int,
+    .sub_int = &scalar_sub_int,
+    .mul_int = &scalar_mul_int,
+    .add_float = &scalar_add_float,
+    .sub_float = &scalar_sub_float,
+    .mul_float = &scalar_mul_float,
+    .cmp_int = &scalar_cmp_int,
+    .cmp_float = &scalar_cmp_float};
+
+#if defined(__x86_64__)
+
+//  ------
+// | SSE2 |
+//  ------
+
+// Integer overflows are detected from sign bits: a sum overflows when both
+// operands have a sign different from the result's, i.e. when
+// `(a ^ s) & (b ^ s)` is negative. Lanes accumulate that mask as they go.
+
+static bool sse2_sum_int(const int64_t *a, size_t n, int64_t *out)
+{
+    __m128i acc = _mm_setzero_si128();
+    __m128i overflow = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)&a[i]);
+        __m128i sum = _mm_add_epi64(acc, x);
+
+        overflow = _mm_or_si128(overflow, _mm_and_si128(_mm_xor_si128(acc, sum), _mm_xor_si128(x, sum)));
+        acc = sum;
+    }
+
+    int64_t lanes[2];
+    int64_t sum;
+
+    _mm_storeu_si128((__m128i *)lanes, acc);
+
+    if (_mm_movemask_pd(_mm_castsi128_pd(overflow)) || __builtin_add_overflow(lanes[0], lanes[1], &sum))
+        return false;
+
+    for (; i < n; ++i) {
+        if (__builtin_add_overflow(sum, a[i], &sum))
+            return false;
+    }
+
+    *out = sum;
+    return true;
+}
+
+static double sse2_sum_float(const double *a, size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(&a[i]));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(&a[i + 2]));
+    }
+
+    double lanes[2];
+
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+
+    double sum = lanes[0] + lanes[1];
+
+    for (; i < n; ++i)
+        sum += a[i];
+
+    return sum;
+}
+
+static double sse2_min_float(const double *a, size_t n)
+{
+    __m128d acc = _mm_set1_pd(a[0]);
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+        acc = _mm_min_pd(_mm_loadu_pd(&a[i]), acc);
+
+    double lanes[2];
+
+    _mm_storeu_pd(lanes, acc);
+
+    double min = lanes[1] < lanes[0] ? lanes[1] : lanes[0];
+
+    for (; i < n; ++i)
+        min = a[i] < min ? a[i] : min;
+
+    return min;
+}
+
+static double sse2_max_float(const double *a, size_t n)
+{
+    __m128d acc = _mm_set1_pd(a[0]);
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+        acc = _mm_max_pd(_mm_loadu_pd(&a[i]), acc);
+
+    double lanes[2];
+
+    _mm_storeu_pd(lanes, acc);
+
+    double max = lanes[1] > lanes[0] ? lanes[1] : lanes[0];
+
+    for (; i < n; ++i)
+        max = a[i] > max ? a[i] : max;
+
+    return max;
+}
+
+static double sse2_dot_float(const double *a, const double *b, size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(&a[i]), _mm_loadu_pd(&b[i])));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(&a[i + 2]), _mm_loadu_pd(&b[i + 2])));
+    }
+
+    double lanes[2];
+
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+
+    double sum = lanes[0] + lanes[1];
+
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+static bool sse2_add_int(int64_t *r, const int64_t *a, const int64_t *b, size_t n)
+{
+    __m128i overflow = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)&a[i]);
+        __m128i y = _mm_loadu_si128((const __m128i *)&b[i]);
+        __m128i sum = _mm_add_epi64(x, y);
+
+        overflow = _mm_or_si128(overflow, _mm_and_si128(_mm_xor_si128(x, sum), _mm_xor_si128(y, sum)));
+        _mm_storeu_si128((__m128i *)&r[i], sum);
+    }
+
+    if (_mm_movemask_pd(_mm_castsi128_pd(overflow)))
+        return false;
+
+    return scalar_add_int(&r[i], &a[i], &b[i], n - i);
+}
+
+// A difference overflows when the operands have different signs,
+// and the result a sign different from the first operand's.
+static bool sse2_sub_int(int64_t *r, const int64_t *a, const int64_t *b, size_t n)
+{
+    __m128i overflow = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)&a[i]);
+        __m128i y = _mm_loadu_si128((const __m128i *)&b[i]);
+        __m128i diff = _mm_sub_epi64(x, y);
+
+        overflow = _mm_or_si128(overflow, _mm_and_si128(_mm_xor_si128(x, y), _mm_xor_si128(x, diff)));
+        _mm_storeu_si128((__m128i *)&r[i], diff);
+    }
+
+    if (_mm_movemask_pd(_mm_castsi128_pd(overflow)))
+        return false;
+
+    return scalar_sub_int(&r[i], &a[i], &b[i], n - i);
+}
+
+static void sse2_add_float(double *r, const double *a, const double *b, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(&r[i], _mm_add_pd(_mm_loadu_pd(&a[i]), _mm_loadu_pd(&b[i])));
+
+    scalar_add_float(&r[i], &a[i], &b[i], n - i);
+}
+
+static void sse2_sub_float(double *r, const double *a, const double *b, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(&r[i], _mm_sub_pd(_mm_loadu_pd(&a[i]), _mm_loadu_pd(&b[i])));
+
+    scalar_sub_float(&r[i], &a[i], &b[i], n - i);
+}
+
+static void sse2_mul_float(double *r, const double *a, const double *b, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(&r[i], _mm_mul_pd(_mm_loadu_pd(&a[i]), _mm_loadu_pd(&b[i])));
+
+    scalar_mul_float(&r[i], &a[i], &b[i], n - i);
+}
+
+static void sse2_cmp_float(int64_t *r, const double *a, const double *b, size_t n, lsimd_cmp_t op)
+{
+    __m128i one = _mm_set1_epi64x(1);
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d x = _mm_loadu_pd(&a[i]);
+        __m128d y = _mm_loadu_pd(&b[i]);
+        __m128d mask = op == LSIMD_EQ ? _mm_cmpeq_pd(x, y) : op == LSIMD_LT ? _mm_cmplt_pd(x, y) : _mm_cmpgt_pd(x, y);
+
+        _mm_storeu_si128((__m128i *)&r[i], _mm_and_si128(_mm_castpd_si128(mask), one));
+    }
+
+    scalar_cmp_float(&r[i], &a[i], &b[i], n - i, op);
+}
+
+// SSE2 has no 64-bit integer comparison nor multiplication,
+// those kernels stay scalar.
+const lsimd_t lsimd_sse2 = {
+    .name = "sse2",
+    .sum_int = &sse2_sum_int,
+    .sum_float = &sse2_sum_float,
+    .min_int = &scalar_min_int,
+    .max_int = &scalar_max_int,
+    .min_float = &sse2_min_float,
+    .max_float = &sse2_max_float,
+    .dot_int = &scalar_dot_int,
+    .dot_float = &sse2_dot_float,
+    .add_int = &sse2_add_int,
+    .sub_int = &sse2_sub_int,
+    .mul_int = &scalar_mul_int,
+    .add_float = &sse2_add_float,
+    .sub_float = &sse2_sub_float,
+    .mul_float = &sse2_mul_float,
+    .cmp_int = &scalar_cmp_int,
+    .cmp_float = &sse2_cmp_float};
+
+//  ------
+// | AVX2 |
+//  ------
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static bool avx2_sum_int(const int64_t *a, size_t n, int64_t *out)
+{
+    __m256i acc = _mm256_setzero_si256();
+    __m256i overflow = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)&a[i]);
+        __m256i sum = _mm256_add_epi64(acc, x);
+
+        overflow = _mm256_or_si256(overflow, _mm256_and_si256(_mm256_xor_si256(acc, sum), _mm256_xor_si256(x, sum)));
+        acc = sum;
+    }
+
+    if (_mm256_movemask_pd(_mm256_castsi256_pd(overflow)))
+        return false;
+
+    int64_t lanes[4];
+    int64_t sum = 0;
+
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+
+    for (size_t j = 0; j < 4; ++j) {
+        if (__builtin_add_overflow(sum, lanes[j], &sum))
+            return false;
+    }
+
+    for (; i < n; ++i) {
+        if (__builtin_add_overflow(sum, a[i], &sum))
+            return false;
+    }
+
+    *out = sum;
+    return true;
+}
+
+AVX2 static double avx2_sum_float(const double *a, size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(&a[i]));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(&a[i + 4]));
+    }
+
+    double lanes[4];
+
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+    for (; i < n; ++i)
+        sum += a[i];
+
+    return sum;
+}
+
+AVX2 static int64_t avx2_min_int(const int64_t *a, size_t n)
+{
+    __m256i acc = _mm256_set1_epi64x(a[0]);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)&a[i]);
+
+        acc = _mm256_blendv_epi8(acc, x, _mm256_cmpgt_epi64(acc, x));
+    }
+
+    int64_t lanes[4];
+
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+
+    int64_t min = scalar_min_int(lanes, 4);
+
+    for (; i < n; ++i)
+        min = a[i] < min ? a[i] : min;
+
+    return min;
+}
+
+AVX2 static int64_t avx2_max_int(const int64_t *a, size_t n)
+{
+    __m256i acc = _mm256_set1_epi64x(a[0]);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)&a[i]);
+
+        acc = _mm256_blendv_epi8(acc, x, _mm256_cmpgt_epi64(x, acc));
+    }
+
+    int64_t lanes[4];
+
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+
+    int64_t max = scalar_max_int(lanes, 4);
+
+    for (; i < n; ++i)
+        max = a[i] > max ? a[i] : max;
+
+    return max;
+}
+
+AVX2 static double avx2_min_float(const double *a, size_t n)
+{
+    __m256d acc = _mm256_set1_pd(a[0]);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        acc = _mm256_min_pd(_mm256_loadu_pd(&a[i]), acc);
+
+    double lanes[4];
+
+    _mm256_storeu_pd(lanes, acc);
+
+    double min = scalar_min_float(lanes, 4);
+
+    for (; i < n; ++i)
+        min = a[i] < min ? a[i] : min;
+
+    return min;
+}
+
+AVX2 static double avx2_max_float(const double *a, size_t n)
+{
+    __m256d acc = _mm256_set1_pd(a[0]);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        acc = _mm256_max_pd(_mm256_loadu_pd(&a[i]), acc);
+
+    double lanes[4];
+
+    _mm256_storeu_pd(lanes, acc);
+
+    double max = scalar_max_float(lanes, 4);
+
+    for (; i < n; ++i)
+        max = a[i] > max ? a[i] : max;
+
+    return max;
+}
+
+AVX2 static double avx2_dot_float(const double *a, const double *b, size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(&a[i]), _mm256_loadu_pd(&b[i])));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(&a[i + 4]), _mm256_loadu_pd(&b[i + 4])));
+    }
+
+    double lanes[4];
+
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+
+    double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+AVX2 static bool avx2_add_int(int64_t *r, const int64_t *a, const int64_t *b, size_t n)
+{
+    __m256i overflow = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)&a[i]);
+        __m256i y = _mm256_loadu_si256((const __m256i *)&b[i]);
+        __m256i sum = _mm256_add_epi64(x, y);
+
+        overflow = _mm256_or_si256(overflow, _mm256_and_si256(_mm256_xor_si256(x, sum), _mm256_xor_si256(y, sum)));
+        _mm256_storeu_si256((__m256i *)&r[i], sum);
+    }
+
+    if (_mm256_movemask_pd(_mm256_castsi256_pd(overflow)))
+        return false;
+
+    return scalar_add_int(&r[i], &a[i], &b[i], n - i);
+}
+
+AVX2 static bool avx2_sub_int(int64_t *r, const int64_t *a, const int64_t *b, size_t n)
+{
+    __m256i overflow = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)&a[i]);
+        __m256i y = _mm256_loadu_si256((const __m256i *)&b[i]);
+        __m256i diff = _mm256_sub_epi64(x, y);
+
+        overflow = _mm256_or_si256(overflow, _mm256_and_si256(_mm256_xor_si256(x, y), _mm256_xor_si256(x, diff)));
+        _mm256_storeu_si256((__m256i *)&r[i], diff);
+    }
+
+    if (_mm256_movemask_pd(_mm256_castsi256_pd(overflow)))
+        return false;
+
+    return scalar_sub_int(&r[i], &a[i], &b[i], n - i);
+}
+
+AVX2 static void avx2_add_float(double *r, const double *a, const double *b, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(&r[i], _mm256_add_pd(_mm256_loadu_pd(&a[i]), _mm256_loadu_pd(&b[i])));
+
+    scalar_add_float(&r[i], &a[i], &b[i], n - i);
+}
+
+AVX2 static void avx2_sub_float(double *r, const double *a, const double *b, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(&r[i], _mm256_sub_pd(_mm256_loadu_pd(&a[i]), _mm256_loadu_pd(&b[i])));
+
+    scalar_sub_float(&r[i], &a[i], &b[i], n - i);
+}
+
+AVX2 static void avx2_mul_float(double *r, const double *a, const double *b, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(&r[i], _mm256_mul_pd(_mm256_loadu_pd(&a[i]), _mm256_loadu_pd(&b[i])));
+
+    scalar_mul_float(&r[i], &a[i], &b[i], n - i);
+}
+
+AVX2 static void avx2_cmp_int(int64_t *r, const int64_t *a, const int64_t *b, size_t n, lsimd_cmp_t op)
+{
+    __m256i one = _mm256_set1_epi64x(1);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)&a[i]);
+        __m256i y = _mm256_loadu_si256((const __m256i *)&b[i]);
+        __m256i mask = op == LSIMD_EQ ? _mm256_cmpeq_epi64(x, y) : op == LSIMD_LT ? _mm256_cmpgt_epi64(y, x) : _mm256_cmpgt_epi64(x, y);
+
+        _mm256_storeu_si256((__m256i *)&r[i], _mm256_and_si256(mask, one));
+    }
+
+    scalar_cmp_int(&r[i], &a[i], &b[i], n - i, op);
+}
+
+AVX2 static void avx2_cmp_float(int64_t *r, const double *a, const double *b, size_t n, lsimd_cmp_t op)
+{
+    __m256i one = _mm256_set1_epi64x(1);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d x = _mm256_loadu_pd(&a[i]);
+        __m256d y = _mm256_loadu_pd(&b[i]);
+        __m256d mask = op == LSIMD_EQ ? _mm256_cmp_pd(x, y, _CMP_EQ_OQ)
+                     : op == LSIMD_LT ? _mm256_cmp_pd(x, y, _CMP_LT_OQ)
+                     : _mm256_cmp_pd(x, y, _CMP_GT_OQ);
+
+        _mm256_storeu_si256((__m256i *)&r[i], _mm256_and_si256(_mm256_castpd_si256(mask), one));
+    }
+
+    scalar_cmp_float(&r[i], &a[i], &b[i], n - i, op);
+}
+
+// AVX2 has no 64-bit integer multiplication, those kernels stay scalar.
+const lsimd_t lsimd_avx2 = {
+    .name = "avx2",
+    .sum_int = &avx2_sum_int,
+    .sum_float = &avx2_sum_float,
+    .min_int = &avx2_min_int,
+    .max_int = &avx2_max_int,
+    .min_float = &avx2_min_float,
+    .max_float = &avx2_max_float,
+    .dot_int = &scalar_dot_int,
+    .dot_float = &avx2_dot_float,
+    .add_int = &avx2_add_int,
+    .sub_int = &avx2_sub_int,
+    .mul_int = &scalar_mul_int,
+    .add_float = &avx2_add_float,
+    .sub_float = &avx2_sub_float,
+    .mul_float = &avx2_mul_float,
+    .cmp_int = &avx2_cmp_int,
+    .cmp_float = &avx2_cmp_float};
+
+#endif // __x86_64__
+
+//  ----------
+// | Dispatch |
+//  ----------
+
+// Check if the running CPU can execute a set of kernels.
+bool lsimd_supported(const lsimd_t *kernels)
+{
+#if defined(__x86_64__)
+    if (kernels == &lsimd_avx2)
+        return __builtin_cpu_supports("avx2");
+#endif
+
+    // The scalar kernels, and SSE2 which is part of x86-64.
+    return true;
+}
+
+// Return the fastest kernels supported by the running CPU, selected once.
+const lsimd_t *lsimd_best(void)
+{
+    static const lsimd_t *best = NULL;
+
+    if (best)
+        return best;
+
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    best = lsimd_supported(&lsimd_avx2) ? &lsimd_avx2 : &lsimd_sse2;
+#else
+    best = &lsimd_scalar;
+#endif
+
+    return best;
+}
@@ -0,0 +1,218 @@
+#include "table.h"
+
+//  -------
+// | Words |
+//  -------
+
+static bool ltable_is_fixnum(ltable_word_t word)
+{
+    return word & 1;
+}
+
+static long ltable_fixnum(ltable_word_t word)
+{
+    return (intptr_t)word >> 1;
+}
+
+// Return the word of a value, a number that fits is stored in it. Takes ownership of the value.
+static ltable_word_t ltable_pack(lval_t *lval)
+{
+    if (lval->type != NUMBER || lval->number < LONG_MIN / 2 || lval->number > LONG_MAX / 2)
+        return (ltable_word_t)lval;
+
+    ltable_word_t word = ((ltable_word_t)lval->number << 1) | 1;
+
+    lval_del(lval);
+
+    return word;
+}
+
+/// @brief Return the value of a word, as a new value owned by the caller.
+lval_t *ltable_unpack(ltable_word_t word)
+{
+    if (ltable_is_fixnum(word))
+        return lval_num(ltable_fixnum(word));
+
+    return lval_clone((lval_t *)word);
+}
+
+static void ltable_word_del(ltable_word_t word)
+{
+    if (!ltable_is_fixnum(word))
+        lval_del((lval_t *)word);
+}
+
+// Whether a word holds a value equal to a key.
+static bool ltable_word_eq(ltable_word_t word, const lval_t *key)
+{
+    // Numbers that fit are always packed, so a packed word can only be equal to one of them.
+    if (ltable_is_fixnum(word))
+        return key->type == NUMBER && key->number == ltable_fixnum(word);
+
+    return lval_eq((lval_t *)word, (lval_t *)key);
+}
+
+//  --------------
+// | Constructors |
+//  --------------
+
+/// @brief Return a table with room for a number of entries, so that
+///        it does not have to grow until it holds more of them.
+/// @param expected number of entries, 0 if unknown.
+ltable_t *ltable_new(size_t expected)
+{
+    ltable_t *table = malloc(sizeof(ltable_t));
+    size_t capacity = LTABLE_MIN_CAPACITY;
+
+    while (capacity / LTABLE_LOAD_DEN * LTABLE_LOAD_NUM < expected)
+        capacity *= 2;
+
+    table->refs = 1;
+    table->count = 0;
+    table->capacity = capacity;
+    table->slots = calloc(capacity, sizeof(ltable_slot_t));
+
+    return table;
+}
+
+ltable_t *ltable_ref(ltable_t *table)
+{
+    ++table->refs;
+
+    return table;
+}
+
+void ltable_unref(ltable_t *table)
+{
+    if (--table->refs)
+        return;
+
+    for (size_t i = 0; i < table->capacity; ++i)
+    {
+        if (table->slots[i].key) {
+            ltable_word_del(table->slots[i].key);
+            ltable_word_del(table->slots[i].value);
+        }
+    }
+
+    free(table->slots);
+    free(table);
+}
+
+//  ---------
+// | Probing |
+//  ---------
+
+// Spread the bits of a hash, so that consecutive keys do not fill consecutive slots.
+static size_t ltable_hash(const lval_t *key)
+{
+    size_t hash = lval_hash(key);
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdUL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+// Distance between a slot and the first one its entry could be in.
+static size_t ltable_distance(const ltable_t *table, size_t index)
+{
+    return (index - table->slots[index].hash) & (table->capacity - 1);
+}
+
+// Return the slot of a key, NULL if the key is missing.
+static ltable_slot_t *ltable_find(const ltable_t *table, const lval_t *key, size_t hash)
+{
+    size_t mask = table->capacity - 1;
+
+    for (size_t index = hash & mask, distance = 0;; index = (index + 1) & mask, ++distance)
+    {
+        ltable_slot_t *slot = &table->slots[index];
+
+        // Entries are sorted by distance, the key would have been before one closer to its slot.
+        if (!slot->key || ltable_distance(table, index) < distance)
+            return NULL;
+
+        if (slot->hash == hash && ltable_word_eq(slot->key, key))
+            return slot;
+    }
+}
+
+// Insert an entry whose key is missing, displacing the entries closer to their slot.
+static void ltable_insert(ltable_t *table, ltable_slot_t entry)
+{
+    size_t mask = table->capacity - 1;
+
+    for (size_t index = entry.hash & mask, distance = 0;; index = (index + 1) & mask, ++distance)
+    {
+        ltable_slot_t *slot = &table->slots[index];
+
+        if (!slot->key) {
+            *slot = entry;
+            return;
+        }
+
+        size_t other = ltable_distance(table, index);
+
+        if (other < distance)
+        {
+            ltable_slot_t swap = *slot;
+
+            *slot = entry;
+            entry = swap;
+            distance = other;
+        }
+    }
+}
+
+static void ltable_grow(ltable_t *table)
+{
+    ltable_slot_t *slots = table->slots;
+    size_t capacity = table->capacity;
+
+    table->capacity *= 2;
+    table->slots = calloc(table->capacity, sizeof(ltable_slot_t));
+
+    for (size_t i = 0; i < capacity; ++i) {
+        if (slots[i].key)
+            ltable_insert(table, slots[i]);
+    }
+
+    free(slots);
+}
+
+//  -----------------------
+// | Lookup & modification |
+//  -----------------------
+
+/// @brief Get the value associated to a key.
+/// @return a copy of the value, or NULL if the key is missing.
+lval_t *ltable_get(const ltable_t *table, const lval_t *key)
+{
+    ltable_slot_t *slot = ltable_find(table, key, ltable_hash(key));
+
+    return slot ? ltable_unpack(slot->value) : NULL;
+}
+
+/// @brief Associate a value to a key, replacing its previous value if any.
+///        Takes ownership of the key and the value.
+void ltable_put(ltable_t *table, lval_t *key, lval_t *value)
+{
+    size_t hash = ltable_hash(key);
+    ltable_slot_t *slot = ltable_find(table, key, hash);
+
+    if (slot)
+    {
+        lval_del(key);
+        ltable_word_del(slot->value);
+        slot->value = ltable_pack(value);
+        return;
+    }
+
+    if (table->count + 1 > table->capacity / LTABLE_LOAD_DEN * LTABLE_LOAD_NUM)
+        ltable_grow(table);
+
+    ltable_insert(table, (ltable_slot_t){hash, ltable_pack(key), ltable_pack(value)});
+    ++table->count;
+}
@@ -0,0 +1,298 @@
+#include "text.h"
+
+//  ---------
+// | Strings |
+//  ---------
+
+/// @brief Return a string holding a copy of a text.
+/// @param length number of bytes of the text, which may include NUL bytes.
+lstr_t *lstr_new(const char *text, size_t length)
+{
+    lstr_t *string = malloc(sizeof(lstr_t) + length + 1);
+
+    string->refs = 1;
+    string->length = length;
+    string->hash = 0;
+    memcpy(string->text, text, length);
+    string->text[length] = '\0';
+
+    return string;
+}
+
+lstr_t *lstr_ref(lstr_t *string)
+{
+    ++string->refs;
+
+    return string;
+}
+
+void lstr_unref(lstr_t *string)
+{
+    if (!--string->refs)
+        free(string);
+}
+
+// Compare two strings, without reading their text when their length
+// or their cached hash already tell them apart.
+bool lstr_eq(const lstr_t *x, const lstr_t *y)
+{
+    if (x == y)
+        return true;
+
+    if (x->length != y->length || (x->hash && y->hash && x->hash != y->hash))
+        return false;
+
+    return memcmp(x->text, y->text, x->length) == 0;
+}
+
+//  -------
+// | Ropes |
+//  -------
+
+/// @brief Return a leaf holding a copy of a text.
+/// @param length number of bytes of the text.
+lrope_t *lrope_leaf(const char *text, size_t length)
+{
+    lrope_t *rope = malloc(sizeof(lrope_t) + length);
+
+    rope->refs = 1;
+    rope->length = length;
+    rope->depth = 0;
+    rope->left = NULL;
+    rope->right = NULL;
+    memcpy(rope->text, text, length);
+
+    return rope;
+}
+
+lrope_t *lrope_ref(lrope_t *rope)
+{
+    ++rope->refs;
+
+    return rope;
+}
+
+void lrope_unref(lrope_t *rope)
+{
+    if (--rope->refs)
+        return;
+
+    if (rope->depth) {
+        lrope_unref(rope->left);
+        lrope_unref(rope->right);
+    }
+
+    free(rope);
+}
+
+// Return a concatenation node. Takes ownership of both children.
+static lrope_t *lrope_node(lrope_t *left, lrope_t *right)
+{
+    lrope_t *rope = malloc(sizeof(lrope_t));
+
+    rope->refs = 1;
+    rope->length = left->length + right->length;
+    rope->depth = (left->depth > right->depth ? left->depth : right->depth) + 1;
+    rope->left = left;
+    rope->right = right;
+
+    return rope;
+}
+
+// Copy the text of a rope into a buffer of at least its length.
+void lrope_copy(const lrope_t *rope, char *buffer)
+{
+    if (!rope->depth) {
+        memcpy(buffer, rope->text, rope->length);
+        return;
+    }
+
+    lrope_copy(rope->left, buffer);
+    lrope_copy(rope->right, buffer + rope->left->length);
+}
+
+// Return the text of a rope as a NUL-terminated string, to be freed by the caller.
+char *lrope_flatten(const lrope_t *rope)
+{
+    char *text = malloc(rope->length + 1);
+
+    lrope_copy(rope, text);
+    text[rope->length] = '\0';
+
+    return text;
+}
+
+// Add references to the leaves of a rope to an array, from left to right.
+static size_t lrope_leaves(lrope_t *rope, lrope_t **leaves, size_t count)
+{
+    if (!rope->depth) {
+        leaves[count] = lrope_ref(rope);
+        return count + 1;
+    }
+
+    count = lrope_leaves(rope->left, leaves, count);
+
+    return lrope_leaves(rope->right, leaves, count);
+}
+
+// Concatenate leaves into a balanced rope. Takes ownership of them.
+static lrope_t *lrope_build(lrope_t **leaves, size_t count)
+{
+    if (count == 1)
+        return leaves[0];
+
+    return lrope_node(lrope_build(leaves, count / 2), lrope_build(leaves + count / 2, count - count / 2));
+}
+
+static size_t lrope_count_leaves(const lrope_t *rope)
+{
+    return rope->depth ? lrope_count_leaves(rope->left) + lrope_count_leaves(rope->right) : 1;
+}
+
+// Rebuild a rope with a minimal depth. Takes ownership of it.
+static lrope_t *lrope_balance(lrope_t *rope)
+{
+    lrope_t **leaves = malloc(sizeof(lrope_t *) * lrope_count_leaves(rope));
+    size_t count = lrope_leaves(rope, leaves, 0);
+
+    lrope_unref(rope);
+    rope = lrope_build(leaves, count);
+    free(leaves);
+
+    return rope;
+}
+
+// Return a leaf with the text of two ropes. Takes ownership of both.
+static lrope_t *lrope_merge(lrope_t *left, lrope_t *right)
+{
+    lrope_t *rope = malloc(sizeof(lrope_t) + left->length + right->length);
+
+    rope->refs = 1;
+    rope->length = left->length + right->length;
+    rope->depth = 0;
+    rope->left = NULL;
+    rope->right = NULL;
+
+    lrope_copy(left, rope->text);
+    lrope_copy(right, rope->text + left->length);
+
+    lrope_unref(left);
+    lrope_unref(right);
+
+    return rope;
+}
+
+/// @brief Concatenate two ropes in O(1), sharing their nodes, except for short
+///        texts which are copied into a single leaf. Takes ownership of both.
+lrope_t *lrope_concat(lrope_t *left, lrope_t *right)
+{
+    if (!right->length) {
+        lrope_unref(right);
+        return left;
+    }
+
+    if (!left->length) {
+        lrope_unref(left);
+        return right;
+    }
+
+    if (left->length + right->length <= LROPE_LEAF_MAX)
+        return lrope_merge(left, right);
+
+    // Appending a short text to a rope ending with a short leaf extends that leaf,
+    // so that building a rope piece by piece does not make a leaf of each piece.
+    if (left->depth && !left->right->depth && !right->depth && left->right->length + right->length <= LROPE_LEAF_MAX)
+    {
+        lrope_t *rope = lrope_node(lrope_ref(left->left), lrope_merge(lrope_ref(left->right), right));
+
+        lrope_unref(left);
+        return rope;
+    }
+
+    lrope_t *rope = lrope_node(left, right);
+
+    return rope->depth > LROPE_MAX_DEPTH ? lrope_balance(rope) : rope;
+}
+
+/// @brief Return the part of a rope from `start` up to, excluding, `end`,
+///        sharing the nodes it fully covers.
+lrope_t *lrope_sub(lrope_t *rope, size_t start, size_t end)
+{
+    if (start == 0 && end == rope->length)
+        return lrope_ref(rope);
+
+    if (!rope->depth)
+        return lrope_leaf(rope->text + start, end - start);
+
+    size_t middle = rope->left->length;
+
+    if (end <= middle)
+        return lrope_sub(rope->left, start, end);
+
+    if (start >= middle)
+        return lrope_sub(rope->right, start - middle, end - middle);
+
+    return lrope_concat(lrope_sub(rope->left, start, middle), lrope_sub(rope->right, 0, end - middle));
+}
+
+//  ----------
+// | Builders |
+//  ----------
+
+/// @brief Return an empty builder.
+/// @param capacity number of bytes to preallocate, 0 if unknown.
+lbuilder_t *lbuilder_new(size_t capacity)
+{
+    lbuilder_t *builder = malloc(sizeof(lbuilder_t));
+
+    builder->refs = 1;
+    builder->length = 0;
+    builder->capacity = capacity ? capacity : 16;
+    builder->text = malloc(builder->capacity);
+
+    return builder;
+}
+
+lbuilder_t *lbuilder_ref(lbuilder_t *builder)
+{
+    ++builder->refs;
+
+    return builder;
+}
+
+void lbuilder_unref(lbuilder_t *builder)
+{
+    if (--builder->refs)
+        return;
+
+    free(builder->text);
+    free(builder);
+}
+
+// Make room for `length` more bytes, doubling the capacity so that appending is amortized O(1).
+static char *lbuilder_reserve(lbuilder_t *builder, size_t length)
+{
+    if (builder->length + length > builder->capacity)
+    {
+        while (builder->length + length > builder->capacity)
+            builder->capacity *= 2;
+
+        builder->text = realloc(builder->text, builder->capacity);
+    }
+
+    char *end = builder->text + builder->length;
+
+    builder->length += length;
+
+    return end;
+}
+
+void lbuilder_append(lbuilder_t *builder, const char *text, size_t length)
+{
+    memcpy(lbuilder_reserve(builder, length), text, length);
+}
+
+void lbuilder_append_rope(lbuilder_t *builder, const lrope_t *rope)
+{
+    lrope_copy(rope, lbuilder_reserve(builder, rope->length));
+}
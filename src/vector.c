@@ -0,0 +1,242 @@
+#include "vector.h"
+
+//  -------
+// | Nodes |
+//  -------
+
+static lvec_node_t *lvec_node_new(void)
+{
+    lvec_node_t *node = calloc(1, sizeof(lvec_node_t));
+
+    node->refs = 1;
+
+    return node;
+}
+
+static lvec_node_t *lvec_node_ref(lvec_node_t *node)
+{
+    if (node)
+        ++node->refs;
+
+    return node;
+}
+
+/// @brief Release a node, freeing it along with its children once nothing refers to it.
+/// @param shift 0 for a leaf.
+static void lvec_node_unref(lvec_node_t *node, unsigned int shift)
+{
+    if (!node || --node->refs)
+        return;
+
+    for (size_t i = 0; i < LVEC_WIDTH; ++i)
+    {
+        if (shift)
+            lvec_node_unref(node->children[i], shift - LVEC_BITS);
+        else if (node->values[i])
+            lval_del(node->values[i]);
+    }
+
+    free(node);
+}
+
+/// @brief Get a node that can be modified in place: the node itself if nothing else
+///        refers to it, a copy otherwise. Creates the node if it is NULL.
+/// @param shift 0 for a leaf.
+static lvec_node_t *lvec_node_edit(lvec_node_t *node, unsigned int shift)
+{
+    if (!node)
+        return lvec_node_new();
+
+    if (node->refs == 1)
+        return node;
+
+    lvec_node_t *copy = lvec_node_new();
+
+    for (size_t i = 0; i < LVEC_WIDTH; ++i)
+    {
+        if (shift)
+            copy->children[i] = lvec_node_ref(node->children[i]);
+        else if (node->values[i])
+            copy->values[i] = lval_clone(node->values[i]);
+    }
+
+    --node->refs;
+
+    return copy;
+}
+
+//  --------------
+// | Constructors |
+//  --------------
+
+lvec_t *lvec_new(void)
+{
+    lvec_t *vec = malloc(sizeof(lvec_t));
+
+    vec->count = 0;
+    vec->shift = LVEC_BITS;
+    vec->root = NULL;
+    vec->tail = NULL;
+
+    return vec;
+}
+
+// Clones share all their nodes, in O(1).
+lvec_t *lvec_clone(const lvec_t *vec)
+{
+    lvec_t *new = malloc(sizeof(lvec_t));
+
+    new->count = vec->count;
+    new->shift = vec->shift;
+    new->root = lvec_node_ref(vec->root);
+    new->tail = lvec_node_ref(vec->tail);
+
+    return new;
+}
+
+void lvec_del(lvec_t *vec)
+{
+    lvec_node_unref(vec->root, vec->shift);
+    lvec_node_unref(vec->tail, 0);
+    free(vec);
+}
+
+//  ----------
+// | Indexing |
+//  ----------
+
+// Index of the first element of the tail.
+static size_t lvec_tail_offset(const lvec_t *vec)
+{
+    return vec->count < LVEC_WIDTH ? 0 : (vec->count - 1) >> LVEC_BITS << LVEC_BITS;
+}
+
+/// @brief Get the element at an index lower than the count of the vector.
+/// @return the element, still owned by the vector.
+lval_t *lvec_nth(const lvec_t *vec, size_t index)
+{
+    if (index >= lvec_tail_offset(vec))
+        return vec->tail->values[index & LVEC_MASK];
+
+    const lvec_node_t *node = vec->root;
+
+    for (unsigned int shift = vec->shift; shift; shift -= LVEC_BITS)
+        node = node->children[(index >> shift) & LVEC_MASK];
+
+    return node->values[index & LVEC_MASK];
+}
+
+//  ---------------
+// | Modifications |
+//  ---------------
+
+// Return a branch leading to a leaf, with nodes for every level above it.
+static lvec_node_t *lvec_new_path(unsigned int shift, lvec_node_t *leaf)
+{
+    if (!shift)
+        return leaf;
+
+    lvec_node_t *node = lvec_node_new();
+
+    node->children[0] = lvec_new_path(shift - LVEC_BITS, leaf);
+
+    return node;
+}
+
+// Insert a full tail as the last leaf of the trie under `node`.
+static lvec_node_t *lvec_push_tail(const lvec_t *vec, unsigned int shift, lvec_node_t *node, lvec_node_t *tail)
+{
+    size_t index = ((vec->count - 1) >> shift) & LVEC_MASK;
+
+    node = lvec_node_edit(node, shift);
+
+    if (shift == LVEC_BITS)
+        node->children[index] = tail;
+    else if (node->children[index])
+        node->children[index] = lvec_push_tail(vec, shift - LVEC_BITS, node->children[index], tail);
+    else
+        node->children[index] = lvec_new_path(shift - LVEC_BITS, tail);
+
+    return node;
+}
+
+/// @brief Append an element to a vector, in amortized O(1).
+///        Only the nodes shared with other vectors are copied.
+///        Takes ownership of the element.
+void lvec_conj(lvec_t *vec, lval_t *value)
+{
+    size_t offset = lvec_tail_offset(vec);
+
+    if (vec->count - offset < LVEC_WIDTH)
+    {
+        vec->tail = lvec_node_edit(vec->tail, 0);
+        vec->tail->values[vec->count++ - offset] = value;
+        return;
+    }
+
+    // The tail is full, it moves into the trie, which grows a level once it is full too.
+    if ((vec->count >> LVEC_BITS) > (1UL << vec->shift))
+    {
+        lvec_node_t *root = lvec_node_new();
+
+        root->children[0] = vec->root;
+        root->children[1] = lvec_new_path(vec->shift, vec->tail);
+
+        vec->root = root;
+        vec->shift += LVEC_BITS;
+    }
+    else
+        vec->root = lvec_push_tail(vec, vec->shift, vec->root, vec->tail);
+
+    vec->tail = lvec_node_new();
+    vec->tail->values[0] = value;
+    ++vec->count;
+}
+
+static lvec_node_t *lvec_assoc_path(unsigned int shift, lvec_node_t *node, size_t index, lval_t *value)
+{
+    node = lvec_node_edit(node, shift);
+
+    size_t slot = (index >> shift) & LVEC_MASK;
+
+    if (shift)
+        node->children[slot] = lvec_assoc_path(shift - LVEC_BITS, node->children[slot], index, value);
+    else {
+        lval_del(node->values[slot]);
+        node->values[slot] = value;
+    }
+
+    return node;
+}
+
+/// @brief Replace the element at an index lower than the count of the vector, in O(log32 n).
+///        Only the nodes shared with other vectors are copied.
+///        Takes ownership of the element.
+void lvec_assoc(lvec_t *vec, size_t index, lval_t *value)
+{
+    if (index >= lvec_tail_offset(vec))
+        vec->tail = lvec_assoc_path(0, vec->tail, index, value);
+    else
+        vec->root = lvec_assoc_path(vec->shift, vec->root, index, value);
+}
+
+//  ------------
+// | Comparison |
+//  ------------
+
+bool lvec_eq(const lvec_t *x, const lvec_t *y)
+{
+    if (x->count != y->count)
+        return false;
+
+    // Versions sharing all their nodes hold the same elements.
+    if (x->root == y->root && x->tail == y->tail)
+        return true;
+
+    for (size_t i = 0; i < x->count; ++i) {
+        if (!lval_eq(lvec_nth(x, i), lvec_nth(y, i)))
+            return false;
+    }
+
+    return true;
+}